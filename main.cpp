@@ -5,25 +5,124 @@
 //   /p <HWND>       preview inside the provided window handle
 //   /w [WxH]        windowed preview (not fullscreen)
 //   /c              config dialog (shows a simple message)
+//   /b[:N]          headless benchmark: hidden window, step every frame for N generations (default 1000)
+//   /r <FILE>       headless replay of an input log written with --record
+//   /v <HOST:PORT>  view a universe served with --serve (window sized by --window)
 //   (no args)       config dialog
 //
+// Options (any mode, in addition to the above):
+//   --cell-px=N               cell size in pixels (default 16)
+//   --engine=NAME             stepping engine: "dense" (default), "runs" (run-length rows; for
+//                             sparse boards, memory and step time scale with the number of runs) or
+//                             "lenia" (continuous states, FFT convolution with a ring kernel, on a torus)
+//   --lenia-radius=N          lenia: kernel radius in cells (default 13)
+//   --lenia-mu=F, --lenia-sigma=F  lenia: centre and width of the growth function (default 0.15, 0.015)
+//   --lenia-dt=F              lenia: time step (default 0.1)
+//   --neighborhood=NAME       "moore" (default), "vonneumann" or "hex" (odd rows offset by half a cell)
+//   --rule=BX/SY              birth/survival counts (default per neighbourhood: moore B3/S23,
+//                             vonneumann B1/S13, hex B2/S34)
+//   --birth-p=F, --survive-p=F  stochastic rules: a birth / survival the rule grants happens with
+//                             probability F (default 1)
+//   --noise=F                 stochastic rules: a cell the rule leaves dead is born anyway with
+//                             probability F (default 0); stochastic universes use the dense engine
+//   --verify                  benchmark: check every step of the engine against the reference kernel
+//   --render-check            benchmark: draw every frame through the texture and as rectangles on
+//                             the software renderer, fail (exit 1) if any pixel differs
+//   --per-display[=N]         a separate universe per display (/s), or N side-by-side universes in
+//                             the window; stepped concurrently on a shared worker pool
+//   --displayK=OPT=V,...      options for universe K (0-based): cell-px, engine, neighborhood, rule,
+//                             density, wrap, gens-per-step, color-cycle, birth-p, survive-p, noise,
+//                             lenia-radius, lenia-mu, lenia-sigma, lenia-dt; implies --per-display
+//   --gens-per-step=K         advance K generations per step, drawing only the last (default 1)
+//   --color-cycle=S           rotate the age colours' hue once every S seconds (default off)
+//   --wrap=on|off             torus (default) or bounded universe
+//   --density=F               initial live fraction (default 0.18)
+//   --window=WxH              window size for /w, /b and /r (default 1280x720)
+//   --export-dir=DIR          where E / Shift+E write pattern files (default: current directory)
+//   --export=PATH             benchmark: export the final grid to PATH (.rle or .cells) and time it
+//   --library=PATH            seed with random placements (8 orientations) from a pattern library
+//                             instead of a soup
+//   --library-count=N         patterns placed per universe (default: one per 256 cells)
+//   --build-library=OUT SRC.. build a library from .rle/.cells files and directories, then exit
+//   --serve=[HOST:]PORT       stream the primary universe to /v viewers over TCP: a keyframe, then
+//                             per-generation liveness deltas (all interfaces unless HOST is given)
+//   --metrics-file=PATH       periodically write Prometheus text-format metrics to PATH (atomic replace)
+//   --metrics-interval=MS     metrics write interval (default 10000)
+//   --synthetic-input         benchmark: inject deterministic paint strokes and window resizes
+//   --alloc-check             benchmark: synthetic input, fail (exit 1) if the main thread allocates
+//                             after warm-up; needs a build with -DCONWAY_ALLOC_HOOK=ON
+//   --soak=S                  benchmark: run for S seconds with synthetic input, sample throughput,
+//                             frame/step percentiles and RSS as CSV, fail (exit 1) on throughput
+//                             drift or steady memory growth
+//   --soak-interval=S         seconds between soak samples (default 10)
+//   --soak-csv=PATH           soak samples go to PATH instead of stdout
+//   --record=PATH             record seed, config and every handled input event to PATH
+//   --replay-speed=MODE       replay: "realtime" (default, recorded timing) or "max" (one
+//                             generation per frame, events keyed to their generation)
+//   --hash-ages               grid checksum covers cell ages, not just liveness
+//   --hash-log=PATH           append "generation hash" for every generation to PATH
+//   --checkpoint=PATH         resume from PATH at start (run/preview modes) and checkpoint the
+//                             grid to it in the background every --checkpoint-interval and on exit
+//   --checkpoint-interval=S   seconds between checkpoints (default 300)
+//   --cost-map                start with the step cost map (P) on
+//   --activity                count, per cell, the generations in which its liveness changed (A exports)
+//   --activity-export=PATH    benchmark: track activity and export it to PATH (.pgm, or .raw) at the end
+//   --census                  start with the object census (O) on
+//   --memory-budget=MB        cap the grids, engine state, staging buffers, textures and checkpoint
+//                             buffers; degrades (drops --verify, textures, then coarsens cells) to fit
+//
 // Interaction:
 //   - LEFT mouse: paint/spawn live cells
 //   - RIGHT mouse: erase cells
+//   - H: print frame/step latency and memory report (stdout)
+//   - A / Shift+A: start the activity map of the universe under the mouse; once running, export it
+//     as a 16-bit PGM / raw little-endian uint16 file
+//   - F: fast-forward the universe under the mouse: 1, 4, 16, 64 generations per step
+//   - C: toggle colour cycling of the universe under the mouse (--color-cycle, or one turn per minute)
+//   - P: toggle the step cost map: translucent per-tile heat of the time spent stepping each tile
+//   - O: toggle the object census of the universe under the mouse: objects counted by kind and the
+//     common ones named, in an overlay (also in the H and exit reports)
+//   - E / Shift+E: export the grid (the universe under the mouse) as RLE / plaintext (.cells),
+//     empty margins trimmed
 //   - ESC: exit (ONLY key that exits)
 //
+// The latency report (with the current generation's grid checksum, per-task frame timings and the
+// step/draw overlap) and a startup timeline (time to first present, grid seeding overlap) are also
+// printed on exit and at the end of a benchmark run. Recordings carry a checksum per generation; a
+// max-speed replay checks them and reports the first generation that diverges. On Linux, benchmarks
+// and soaks also report RAPL package/DRAM energy per generation and per frame when the powercap
+// counters are readable.
+//
 // Build on Windows: compile as a GUI app (Subsystem: Windows), then rename output to .scr.
 
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_syswm.h>
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <condition_variable>
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
 #include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
 #include <random>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #ifdef _WIN32
@@ -33,17 +132,142 @@
   #ifndef WIN32_LEAN_AND_MEAN
     #define WIN32_LEAN_AND_MEAN
   #endif
+  #include <winsock2.h>
+  #include <ws2tcpip.h>
   #include <windows.h>
+  #include <psapi.h>
+  #include <tlhelp32.h>
+  #include <io.h>
+#else
+  #include <fcntl.h>
+  #include <netdb.h>
+  #include <netinet/in.h>
+  #include <netinet/tcp.h>
+  #include <poll.h>
+  #include <sys/mman.h>
+  #include <sys/socket.h>
+  #include <sys/stat.h>
+  #include <unistd.h>
+#endif
+
+#ifdef CONWAY_HAVE_LIBURING
+  #include <liburing.h>
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+  #define CONWAY_SSE2 1
+  #include <emmintrin.h>
+  #ifdef __SSE4_1__
+    #include <smmintrin.h>
+  #endif
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+  #define CONWAY_NEON 1
+  #include <arm_neon.h>
 #endif
 
+enum class Engine { Dense, Runs, Lenia };
+enum class Neighborhood { Moore, VonNeumann, Hex };
+
+static const char* engineName(Engine e) {
+    switch (e) {
+        case Engine::Runs:  return "runs";
+        case Engine::Lenia: return "lenia";
+        default:            return "dense";
+    }
+}
+
+static const char* neighborhoodName(Neighborhood n) {
+    switch (n) {
+        case Neighborhood::VonNeumann: return "vonneumann";
+        case Neighborhood::Hex:        return "hex";
+        default:                       return "moore";
+    }
+}
+
+// Outer-totalistic rule: bit n of birth/survive = a dead/live cell with n live neighbours is alive
+// in the next generation.
+struct Rule {
+    uint16_t birth = 1u << 3;
+    uint16_t survive = (1u << 2) | (1u << 3);
+};
+
 struct Config {
+    Engine engine = Engine::Dense;
+    Neighborhood neighborhood = Neighborhood::Moore;
+    Rule rule;               // --rule; defaults to the neighbourhood's default rule
+    bool rule_set = false;
+    double birth_p = 1.0;    // stochastic rules: probability that a birth the rule grants happens,
+    double survive_p = 1.0;  // that a survival does,
+    double noise = 0.0;      // and that a cell the rule leaves dead is born anyway
+    int lenia_radius = 13;   // --engine=lenia: kernel radius in cells,
+    double lenia_mu = 0.15;  // growth centre and width,
+    double lenia_sigma = 0.015;
+    double lenia_dt = 0.1;   // and time step
     int cell_px = 16;
     int ms_per_step = 1000;
+    int gens_per_step = 1;   // generations advanced per step (F cycles it while running)
+    int color_cycle_s = 0;   // seconds per full turn of the age colours' hue; 0 = fixed colours
     double density = 0.18;
     bool wrap = true;
     int max_age = 30; // 1..255
+    int target_fps = 0; // frame deadline for latency reports; 0 = display refresh rate (fallback 60)
+    std::string metrics_file;     // empty = metrics export disabled
+    int metrics_interval_ms = 10000;
+    bool synthetic_input = false; // benchmark only
+    bool alloc_check = false;     // benchmark only
+    std::string record_file;      // empty = no input recording
+    bool replay_max_speed = false;
+    bool hash_ages = false;
+    std::string hash_log_file;    // empty = no per-generation hash log
+    std::string checkpoint_file;  // empty = no checkpointing
+    int checkpoint_interval_s = 300;
+    std::string export_dir;       // empty = current directory
+    std::string bench_export;     // benchmark only
+    bool verify = false;          // benchmark only
+    int memory_budget_mb = 0;     // 0 = no budget
+    bool cost_map = false;        // start with the step cost map (P) on
+    int soak_s = 0;               // benchmark only: run for this long instead of N generations
+    int soak_interval_s = 10;
+    std::string soak_csv;         // empty = stdout
+    bool activity = false;        // track the activity map from the start
+    bool census = false;          // start with the object census (O) on
+    std::string activity_export;  // benchmark only
+    bool render_check = false;    // benchmark only
+    std::string serve;            // [HOST:]PORT for the delta stream; empty = not serving
+    std::string library;          // seed from this pattern library instead of a soup; empty = soup
+    int library_count = 0;        // patterns placed per universe; 0 = one per 256 cells
+    std::string build_library;    // write a library built from the positional sources, then exit
 };
 
+// ---------------- Allocation counting (CONWAY_ALLOC_HOOK builds) ----------------
+// Replaces global operator new/delete so the benchmark can prove the steady-state loop does not
+// allocate. Only allocations made by a thread that armed the counter are counted, so background
+// threads (metrics export) do not trip the check.
+
+#ifdef CONWAY_ALLOC_HOOK
+#if defined(__GNUC__) && !defined(__clang__) && __GNUC__ >= 11
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // new and delete below are a matched malloc/free pair
+#endif
+static std::atomic<uint64_t> g_alloc_count{0};
+static thread_local bool t_count_allocs = false;
+
+void* operator new(std::size_t n) {
+    if (t_count_allocs) g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(n ? n : 1)) return p;
+    throw std::bad_alloc();
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+static void armAllocCounter(bool on) { t_count_allocs = on; }
+static uint64_t allocCount() { return g_alloc_count.load(std::memory_order_relaxed); }
+static constexpr bool kAllocHook = true;
+#else
+static void armAllocCounter(bool) {}
+static uint64_t allocCount() { return 0; }
+static constexpr bool kAllocHook = false;
+#endif
+
 static int mod(int a, int m) { int r = a % m; return (r < 0) ? r + m : r; }
 static inline int idx(int x, int y, int w) { return y * w + x; }
 
@@ -77,102 +301,5194 @@ static SDL_Color hsvToRgb(float h_deg, float s, float v) {
     return out;
 }
 
-static SDL_Color colorForAge(uint8_t age, int max_age) {
+// hue_shift (degrees) rotates the whole age ramp; colour cycling advances it over time.
+static SDL_Color colorForAge(uint8_t age, int max_age, float hue_shift = 0.0f) {
     if (age == 0) return SDL_Color{0, 0, 0, 255};
 
     int ma = std::max(1, max_age);
     float t = (ma == 1) ? 0.0f : (float)(std::min<int>(age, ma) - 1) / (float)(ma - 1); // 0..1
 
-    float hue = 200.0f * (1.0f - t); // 200 -> 0
+    float hue = 200.0f * (1.0f - t) + hue_shift; // 200 -> 0
     float sat = 1.0f;
     float val = 1.0f - 0.65f * t;    // 1.0 -> 0.35
 
     return hsvToRgb(hue, sat, val);
 }
 
-static int countNeighbors(const std::vector<uint8_t>& g, int x, int y, int w, int h, bool wrap) {
-    int c = 0;
+// Lenia states (0..255 for 0..1): dark blue through violet and red to bright yellow.
+static SDL_Color colorForState(uint8_t level, float hue_shift = 0.0f) {
+    if (level == 0) return SDL_Color{0, 0, 0, 255};
+    float t = (float)level / 255.0f;
+    return hsvToRgb(240.0f + 180.0f * t + hue_shift, 1.0f - 0.4f * t * t, 0.2f + 0.8f * t);
+}
+
+static SDL_Color cellColor(const Config& c, uint8_t v, float hue_shift) {
+    return c.engine == Engine::Lenia ? colorForState(v, hue_shift) : colorForAge(v, c.max_age, hue_shift);
+}
+
+// ---------------- Memory accounting ----------------
+
+// Subsystems whose memory is tracked (capacities, so reserved but unused space counts too).
+enum class MemoryKind { Grids, Tiles, Runs, Lenia, Staging, Textures, Activity, Census, Verify, Stream, Checkpoint, Count };
+static constexpr int kMemoryKinds = (int)MemoryKind::Count;
+
+static const char* memoryKindName(MemoryKind k) {
+    switch (k) {
+        case MemoryKind::Grids:      return "grids";      // cur/nxt
+        case MemoryKind::Tiles:      return "tiles";      // change flags, tile hashes, per-step scratch
+        case MemoryKind::Runs:       return "runs";       // run-length engine rows and scratch
+        case MemoryKind::Staging:    return "staging";    // raster staging buffers
+        case MemoryKind::Textures:   return "textures";   // streaming textures (driver memory, estimated)
+        case MemoryKind::Activity:   return "activity";   // per-cell activity counters
+        case MemoryKind::Census:     return "census";     // object census labels, clusters and overlay
+        case MemoryKind::Verify:     return "verify";     // --verify reference buffers
+        case MemoryKind::Lenia:      return "lenia";      // state, spectra and FFT scratch
+        case MemoryKind::Stream:     return "stream";     // --serve frames and viewer queues
+        default:                     return "checkpoint"; // snapshot and output buffers
+    }
+}
+
+struct MemoryLedger {
+    std::array<uint64_t, kMemoryKinds> bytes{};
+
+    uint64_t& operator[](MemoryKind k) { return bytes[(size_t)k]; }
+    uint64_t total() const {
+        uint64_t t = 0;
+        for (uint64_t b : bytes) t += b;
+        return t;
+    }
+};
+
+static double mib(uint64_t bytes) { return (double)bytes / (1024.0 * 1024.0); }
+
+// ---------------- Latency histograms ----------------
+
+// v must be non-zero.
+static int lowestBit(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long i = 0;
+    _BitScanForward64(&i, v);
+    return (int)i;
+#else
+    return __builtin_ctzll(v);
+#endif
+}
+
+// v must be non-zero.
+static int highestBit(uint64_t v) {
+#if defined(_MSC_VER)
+    unsigned long i = 0;
+    _BitScanReverse64(&i, v);
+    return (int)i;
+#else
+    return 63 - __builtin_clzll(v);
+#endif
+}
+
+// Single-writer counter: only the owning thread writes (plain load + store, no locked RMW), any
+// thread may read. Lets background readers sample hot-path counters without locks or contention.
+struct RelaxedCounter {
+    std::atomic<uint64_t> v{0};
+
+    void add(uint64_t n) { v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed); }
+    void set(uint64_t n) { v.store(n, std::memory_order_relaxed); }
+    uint64_t get() const { return v.load(std::memory_order_relaxed); }
+};
+
+// HDR-style log-bucketed histogram of durations in nanoseconds. Values below 64 are exact; above
+// that each power of two is split into 64 linear sub-buckets, so a reported percentile is within
+// ~1.6% of the true value. Fixed size, no allocation on record(). Written by one thread; other
+// threads may read it concurrently and see a slightly stale but usable distribution.
+struct LatencyHistogram {
+    static constexpr int kSubBits = 6;
+    static constexpr int kSubBuckets = 1 << kSubBits;
+    static constexpr int kOctaves = 42; // covers up to ~2^47 ns (~39 h)
+    static constexpr int kBuckets = (kOctaves + 1) * kSubBuckets;
+
+    std::array<RelaxedCounter, kBuckets> buckets;
+    RelaxedCounter total;
+    RelaxedCounter sum_ns;
+    RelaxedCounter max_ns;
+
+    static int bucketFor(uint64_t ns) {
+        if (ns < (uint64_t)kSubBuckets) return (int)ns;
+        int octave = highestBit(ns) - kSubBits + 1;
+        if (octave > kOctaves) return kBuckets - 1;
+        return octave * kSubBuckets + (int)((ns >> (octave - 1)) - kSubBuckets);
+    }
+
+    // Highest value that maps to bucket b.
+    static uint64_t bucketUpper(int b) {
+        int octave = b / kSubBuckets;
+        uint64_t sub = (uint64_t)(b % kSubBuckets);
+        if (octave == 0) return sub;
+        return ((kSubBuckets + sub + 1) << (octave - 1)) - 1;
+    }
+
+    void record(uint64_t ns) {
+        buckets[bucketFor(ns)].add(1);
+        total.add(1);
+        sum_ns.add(ns);
+        if (ns > max_ns.get()) max_ns.set(ns);
+    }
+
+    uint64_t count() const { return total.get(); }
+    uint64_t max() const { return max_ns.get(); }
+
+    // p in [0, 100]. Ranks against the bucket sum rather than `total` so a concurrent reader never
+    // runs past the buckets it has seen.
+    uint64_t percentile(double p) const {
+        uint64_t n = 0;
+        for (const auto& b : buckets) n += b.get();
+        if (n == 0) return 0;
+        uint64_t rank = (uint64_t)std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * (double)n);
+        rank = std::max<uint64_t>(rank, 1);
+        uint64_t seen = 0;
+        for (int b = 0; b < kBuckets; ++b) {
+            seen += buckets[b].get();
+            if (seen >= rank) return std::min(bucketUpper(b), max());
+        }
+        return max();
+    }
+
+    void reset() {
+        for (auto& b : buckets) b.set(0);
+        total.set(0);
+        sum_ns.set(0);
+        max_ns.set(0);
+    }
+};
+
+// Bucket counts of a histogram at one moment; two snapshots give the distribution in between.
+struct HistogramSnapshot {
+    std::array<uint64_t, LatencyHistogram::kBuckets> counts{};
+
+    void take(const LatencyHistogram& h) {
+        for (int b = 0; b < LatencyHistogram::kBuckets; ++b) counts[(size_t)b] = h.buckets[(size_t)b].get();
+    }
+    // p in [0, 100], over the values recorded since `prev`.
+    uint64_t percentileSince(const HistogramSnapshot& prev, double p) const {
+        uint64_t n = 0;
+        for (int b = 0; b < LatencyHistogram::kBuckets; ++b) n += counts[(size_t)b] - prev.counts[(size_t)b];
+        if (n == 0) return 0;
+        uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(std::clamp(p, 0.0, 100.0) / 100.0 * (double)n));
+        uint64_t seen = 0;
+        for (int b = 0; b < LatencyHistogram::kBuckets; ++b) {
+            seen += counts[(size_t)b] - prev.counts[(size_t)b];
+            if (seen >= rank) return LatencyHistogram::bucketUpper(b);
+        }
+        return 0;
+    }
+};
+
+struct FrameStats {
+    LatencyHistogram frame; // start of one loop iteration to the start of the next
+    LatencyHistogram step;  // stepLife + swap only
+    LatencyHistogram snapshot; // main-thread cost of taking a checkpoint snapshot
+
+    // Frame graph tasks other than the step (see the main loop). step_busy_ns / step_overlap_ns is the
+    // share of step time that ran while the previous generation was rasterised and presented.
+    LatencyHistogram input;   // events and replay, main thread
+    LatencyHistogram tally;   // population sum and grid checksum after a step, on the pool
+    LatencyHistogram raster;  // cells to the staging buffers, on the pool
+    LatencyHistogram census;  // object census of the changed tiles, on the pool
+    LatencyHistogram upload;  // staging buffers to the textures, main thread
+    LatencyHistogram present; // clear, copy and present, main thread
+    LatencyHistogram record;  // input recording and hash log, main thread
+    RelaxedCounter step_busy_ns, step_overlap_ns;
+    uint64_t deadline_ns = 16666667;
+    RelaxedCounter frames_missed;
+    RelaxedCounter steps_missed;
+
+    // Maintained by the main loop for background readers (metrics export).
+    RelaxedCounter generation;
+    RelaxedCounter population;
+    RelaxedCounter grid_hash;
+    RelaxedCounter grid_w, grid_h;
+    std::array<RelaxedCounter, kMemoryKinds> memory; // bytes per MemoryKind
+    RelaxedCounter memory_budget;                    // bytes; 0 = none
+    const char* engine = "dense";
+    const char* neighborhood = "moore";
+
+    void recordFrame(uint64_t ns) {
+        frame.record(ns);
+        if (ns > deadline_ns) frames_missed.add(1);
+    }
+    void recordStep(uint64_t ns) {
+        step.record(ns);
+        if (ns > deadline_ns) steps_missed.add(1);
+    }
+};
+
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point a, std::chrono::steady_clock::time_point b) {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(b - a).count();
+}
+
+static void printHistogramLine(std::ostream& os, const char* name, const LatencyHistogram& h, uint64_t missed) {
+    auto ms = [](uint64_t ns) { return (double)ns / 1e6; };
+    os << std::left << std::setw(7) << name << std::right
+       << " n=" << h.count()
+       << std::fixed << std::setprecision(3)
+       << "  p50=" << ms(h.percentile(50.0))
+       << "  p90=" << ms(h.percentile(90.0))
+       << "  p99=" << ms(h.percentile(99.0))
+       << "  p99.9=" << ms(h.percentile(99.9))
+       << "  max=" << ms(h.max()) << " ms"
+       << "  missed=" << missed << "\n";
+}
+
+static void printLatencyReport(std::ostream& os, const FrameStats& st) {
+    os << "generation " << st.generation.get() << "  hash " << std::hex << std::setw(16) << std::setfill('0')
+       << st.grid_hash.get() << std::dec << std::setfill(' ') << "\n";
+    os << "latency report (deadline " << std::fixed << std::setprecision(3)
+       << (double)st.deadline_ns / 1e6 << " ms)\n";
+    printHistogramLine(os, "frame", st.frame, st.frames_missed.get());
+    printHistogramLine(os, "step", st.step, st.steps_missed.get());
+    if (st.snapshot.count()) printHistogramLine(os, "ckpt", st.snapshot, 0);
+    if (st.present.count()) {
+        for (const auto& [name, h] : {std::pair<const char*, const LatencyHistogram*>{"input", &st.input},
+                                      {"stats", &st.tally}, {"raster", &st.raster}, {"census", &st.census},
+                                      {"upload", &st.upload},
+                                      {"present", &st.present}, {"record", &st.record}}) {
+            if (h->count()) printHistogramLine(os, name, *h, 0);
+        }
+        // Busy time of all tasks per frame over the frame time: above 1 means tasks overlapped.
+        uint64_t busy = st.input.sum_ns.get() + st.step.sum_ns.get() + st.tally.sum_ns.get() + st.raster.sum_ns.get() +
+                        st.census.sum_ns.get() + st.upload.sum_ns.get() + st.present.sum_ns.get() + st.record.sum_ns.get();
+        uint64_t step_ns = st.step_busy_ns.get();
+        os << "pipeline: " << std::fixed << std::setprecision(0)
+           << (step_ns ? 100.0 * (double)st.step_overlap_ns.get() / (double)step_ns : 0.0)
+           << "% of step time overlapped raster/upload/present; " << std::setprecision(2)
+           << (st.frame.sum_ns.get() ? (double)busy / (double)st.frame.sum_ns.get() : 0.0)
+           << " average task concurrency\n";
+    }
+    os.flush();
+}
+
+static void printMemoryReport(std::ostream& os, const FrameStats& st) {
+    uint64_t total = 0;
+    os << "memory:" << std::fixed << std::setprecision(2);
+    for (int k = 0; k < kMemoryKinds; ++k) {
+        uint64_t b = st.memory[(size_t)k].get();
+        total += b;
+        if (b) os << "  " << memoryKindName((MemoryKind)k) << "=" << mib(b);
+    }
+    os << "  total=" << mib(total) << " MiB";
+    if (st.memory_budget.get()) os << " (budget " << mib(st.memory_budget.get()) << " MiB)";
+    os << "\n";
+    os.flush();
+}
+
+// ---------------- Startup timing ----------------
+
+// Milestones of the launch, in ms since main() was entered. The grid is seeded on a worker thread
+// while the window and renderer are created; its span is kept separately to report the overlap.
+struct StartupTimeline {
+    struct Mark {
+        const char* name;
+        uint64_t ns;
+    };
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    std::array<Mark, 10> marks{};
+    int n = 0;
+    uint64_t seed_begin_ns = 0, seed_end_ns = 0; // worker span
+    uint64_t join_ns = 0;                        // main thread started waiting for the worker
+    bool seeded_on_worker = false;
+    uint32_t library_patterns = 0;               // --library: patterns in the mapped library
+    uint64_t library_open_ns = 0;
+    uint64_t library_placed = 0;                 // placements across all universes
+
+    uint64_t now() const { return elapsedNs(t0, std::chrono::steady_clock::now()); }
+    void mark(const char* name) {
+        if (n < (int)marks.size()) marks[(size_t)n++] = Mark{name, now()};
+    }
+    uint64_t at(const char* name) const {
+        for (int i = 0; i < n; ++i) if (std::strcmp(marks[(size_t)i].name, name) == 0) return marks[(size_t)i].ns;
+        return 0;
+    }
+};
+
+static void printStartupReport(std::ostream& os, const StartupTimeline& st) {
+    auto ms = [](uint64_t ns) { return (double)ns / 1e6; };
+    os << "startup (ms since launch):" << std::fixed << std::setprecision(2);
+    for (int i = 0; i < st.n; ++i) os << "  " << st.marks[(size_t)i].name << "=" << ms(st.marks[(size_t)i].ns);
+    os << "\n";
+    uint64_t seed_ns = st.seed_end_ns - st.seed_begin_ns;
+    os << "  time to first present " << ms(st.at("first_present")) << " ms; grid seeded in " << ms(seed_ns) << " ms";
+    if (st.seeded_on_worker) {
+        uint64_t hidden = std::min(st.seed_end_ns, st.join_ns) - std::min(st.seed_begin_ns, st.join_ns);
+        os << " on a worker (" << std::setprecision(0) << (seed_ns ? 100.0 * (double)hidden / (double)seed_ns : 100.0)
+           << "% overlapped with window setup)";
+    }
+    os << "\n";
+    if (st.library_patterns) {
+        os << "  library: " << st.library_placed << " patterns placed from " << st.library_patterns
+           << " (mapped and checked in " << std::setprecision(2) << ms(st.library_open_ns) << " ms)\n";
+    }
+    os.flush();
+}
+
+// ---------------- Tiles and grid checksum ----------------
+
+static constexpr int kTileShift = 6; // 64x64-cell tiles
+static constexpr int kTileSize = 1 << kTileShift;
+
+// Per-tile "liveness changed" flags. Set by stepLife and painting; consumers read them once per
+// frame (after the step) and the main loop clears them.
+struct TileGrid {
+    int tiles_x = 0, tiles_y = 0;
+    std::vector<uint8_t> changed;
+
+    void reserve(int grid_w, int grid_h) {
+        changed.reserve((size_t)((grid_w + kTileSize - 1) >> kTileShift) * ((grid_h + kTileSize - 1) >> kTileShift));
+    }
+    void resize(int grid_w, int grid_h) {
+        tiles_x = (grid_w + kTileSize - 1) >> kTileShift;
+        tiles_y = (grid_h + kTileSize - 1) >> kTileShift;
+        changed.assign((size_t)tiles_x * tiles_y, 1);
+    }
+    void mark(int x, int y) { changed[(size_t)(y >> kTileShift) * tiles_x + (x >> kTileShift)] = 1; }
+    void markAll() { std::fill(changed.begin(), changed.end(), 1); }
+    void clear() { std::fill(changed.begin(), changed.end(), 0); }
+};
+
+static constexpr uint64_t kP1 = 0x9E3779B185EBCA87ull;
+static constexpr uint64_t kP2 = 0xC2B2AE3D27D4EB4Full;
+static constexpr uint64_t kP3 = 0x165667B19E3779F9ull;
+static constexpr uint64_t kP5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t rotl64(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+static inline uint64_t hashRound(uint64_t acc, uint64_t in) { return rotl64(acc + in * kP2, 31) * kP1; }
+static inline uint64_t avalanche64(uint64_t h) {
+    h ^= h >> 33; h *= kP2;
+    h ^= h >> 29; h *= kP3;
+    h ^= h >> 32;
+    return h;
+}
+
+// High bit of each byte set iff that byte (cell) is non-zero: 8 cells' liveness per operation.
+static inline uint64_t nonZeroBytes(uint64_t v) {
+    constexpr uint64_t lo7 = 0x7F7F7F7F7F7F7F7Full;
+    return (((v & lo7) + lo7) | v) & ~lo7;
+}
+
+static inline uint64_t load64(const uint8_t* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+// Hash one tile, 8 cells per word into four independent lanes (xxHash-style rounds), so the
+// multiplies pipeline instead of forming one serial chain.
+static uint64_t hashTile(const uint8_t* g, int w, int x0, int y0, int tw, int th, bool ages, uint64_t tile_index) {
+    uint64_t lane[4] = {kP1 + kP2, kP2, 0, 0 - kP1};
+    int k = 0;
+    for (int y = y0; y < y0 + th; ++y) {
+        const uint8_t* row = g + (size_t)y * w + x0;
+        int x = 0;
+        for (; x + 8 <= tw; x += 8) {
+            uint64_t v = load64(row + x);
+            lane[k & 3] = hashRound(lane[k & 3], ages ? v : nonZeroBytes(v));
+            ++k;
+        }
+        if (x < tw) {
+            uint64_t v = 0;
+            std::memcpy(&v, row + x, (size_t)(tw - x));
+            lane[k & 3] = hashRound(lane[k & 3], ages ? v : nonZeroBytes(v));
+            ++k;
+        }
+    }
+    uint64_t h = rotl64(lane[0], 1) + rotl64(lane[1], 7) + rotl64(lane[2], 12) + rotl64(lane[3], 18);
+    return avalanche64(h ^ (tile_index * kP5));
+}
+
+// 64-bit fingerprint of a grid's liveness (optionally ages): the sum of independent per-tile
+// hashes, so after a step only tiles flagged in TileGrid are rehashed.
+struct GridHash {
+    bool ages = false;
+    int w = 0, h = 0;
+    std::vector<uint64_t> tile_hash;
+    uint64_t sum = 0;
+
+    void reserve(const TileGrid& t) { tile_hash.reserve(t.changed.capacity()); }
+
+    void update(const std::vector<uint8_t>& g, int grid_w, int grid_h, const TileGrid& tiles) {
+        bool all = (grid_w != w || grid_h != h || tile_hash.size() != tiles.changed.size());
+        if (all) {
+            w = grid_w;
+            h = grid_h;
+            tile_hash.assign(tiles.changed.size(), 0);
+            sum = 0;
+        }
+        for (int ty = 0; ty < tiles.tiles_y; ++ty) {
+            for (int tx = 0; tx < tiles.tiles_x; ++tx) {
+                size_t t = (size_t)ty * tiles.tiles_x + tx;
+                // Age-inclusive hashes change wherever anything lives, so rehash everything.
+                if (!all && !ages && !tiles.changed[t]) continue;
+                int x0 = tx << kTileShift, y0 = ty << kTileShift;
+                uint64_t hv = hashTile(g.data(), w, x0, y0, std::min(kTileSize, w - x0), std::min(kTileSize, h - y0),
+                                       ages, t);
+                sum += hv - tile_hash[t];
+                tile_hash[t] = hv;
+            }
+        }
+    }
+
+    uint64_t value() const {
+        return avalanche64(sum ^ (((uint64_t)(uint32_t)w << 32) | (uint32_t)h) ^ (ages ? kP3 : 0));
+    }
+};
+
+// ---------------- Activity map ----------------
+//
+// Per-cell 16-bit counters of the generations in which the cell's liveness changed, saturating at
+// 65535. The engines update them while they step a row, so the map costs no extra pass over the grid.
+
+static constexpr uint64_t kLaneLsb16 = 0x0001000100010001ull;
+static constexpr uint64_t kLaneLow15 = 0x7FFF7FFF7FFF7FFFull;
+
+// Bits 0, 8, 16, 24 (one per cell) to bits 0, 16, 32, 48 (one per 16-bit counter).
+static inline uint64_t spreadToLanes16(uint64_t m) {
+    m = (m & 0x0000FFFFull) | ((m & 0xFFFF0000ull) << 16);
+    return (m & 0x000000FF000000FFull) | ((m & 0x0000FF000000FF00ull) << 8);
+}
+
+// Four 16-bit counters += inc (0 or 1 per lane), saturating: full lanes are left alone, so no carry
+// crosses into the next lane.
+static inline uint64_t saturatingInc16(uint64_t counters, uint64_t inc) {
+    uint64_t t = ~counters; // lane zero iff the counter is full
+    uint64_t not_full = ((((t & kLaneLow15) + kLaneLow15) | t) >> 15) & kLaneLsb16;
+    return counters + (inc & not_full);
+}
+
+// Cells [x0, x1) of one row, before -> after: 8 cells per word.
+static void accumulateActivity(const uint8_t* before, const uint8_t* after, uint16_t* act, int x0, int x1) {
+    int x = x0;
+    for (; x + 8 <= x1; x += 8) {
+        uint64_t flips = (nonZeroBytes(load64(before + x)) ^ nonZeroBytes(load64(after + x))) >> 7;
+        if (!flips) continue;
+        uint64_t lo, hi;
+        std::memcpy(&lo, act + x, sizeof(lo));
+        std::memcpy(&hi, act + x + 4, sizeof(hi));
+        lo = saturatingInc16(lo, spreadToLanes16(flips & 0xFFFFFFFFull));
+        hi = saturatingInc16(hi, spreadToLanes16(flips >> 32));
+        std::memcpy(act + x, &lo, sizeof(lo));
+        std::memcpy(act + x + 4, &hi, sizeof(hi));
+    }
+    for (; x < x1; ++x) act[x] += ((before[x] != 0) != (after[x] != 0)) & (act[x] != 0xFFFF);
+}
+
+// One row given as runs [start, end) before (a) and after (b): a cell flipped iff it lies in exactly
+// one of the two lists, so each boundary of either list toggles between flipped and unchanged.
+static void accumulateActivityRuns(uint16_t* act, const int32_t* a, int an, const int32_t* b, int bn) {
+    int i = 0, j = 0;
+    bool flipped = false;
+    int32_t from = 0;
+    while (i < 2 * an || j < 2 * bn) {
+        int32_t x = (j >= 2 * bn || (i < 2 * an && a[i] <= b[j])) ? a[i++] : b[j++];
+        if (flipped) {
+            for (int32_t k = from; k < x; ++k) act[k] += act[k] != 0xFFFF;
+        }
+        flipped = !flipped;
+        from = x;
+    }
+}
+
+// ---------------- Neighbourhoods and rules ----------------
+//
+// Hex grids use the "odd-r" offset layout: odd rows are drawn half a cell to the right, so a cell's
+// upper and lower neighbours sit at dx -1,0 on even rows and dx 0,+1 on odd rows. With wrap on and
+// an odd grid height the seam joins two rows of the same parity, which shears the torus slightly.
+
+static Rule defaultRule(Neighborhood n) {
+    Rule r;
+    switch (n) {
+        case Neighborhood::VonNeumann: r.birth = 1u << 1; r.survive = (1u << 1) | (1u << 3); break;
+        case Neighborhood::Hex:        r.birth = 1u << 2; r.survive = (1u << 3) | (1u << 4); break;
+        default: break;
+    }
+    return r;
+}
+
+// "B3/S23" (also accepts lower case and the S../B.. order); counts above 8 and B0 are rejected.
+static bool parseRule(const std::string& s, Rule& out) {
+    Rule r{0, 0};
+    uint16_t* cur = nullptr;
+    bool seen_b = false, seen_s = false;
+    for (char ch : s) {
+        if (ch == 'B' || ch == 'b') { cur = &r.birth; seen_b = true; }
+        else if (ch == 'S' || ch == 's') { cur = &r.survive; seen_s = true; }
+        else if (ch == '/') cur = nullptr;
+        else if (ch >= '0' && ch <= '8' && cur) *cur |= (uint16_t)(1u << (ch - '0'));
+        else return false;
+    }
+    if (!seen_b || !seen_s || (r.birth & 1)) return false; // B0 would light up every empty region
+    out = r;
+    return true;
+}
+
+// Rule in Golly notation: von Neumann and hex rules carry a V / H suffix.
+static std::string ruleString(Rule r, Neighborhood n) {
+    std::string s = "B";
+    for (int i = 0; i <= 8; ++i) if (r.birth >> i & 1) s += (char)('0' + i);
+    s += "/S";
+    for (int i = 0; i <= 8; ++i) if (r.survive >> i & 1) s += (char)('0' + i);
+    if (n == Neighborhood::VonNeumann) s += "V";
+    if (n == Neighborhood::Hex) s += "H";
+    return s;
+}
+
+// Reference definition of each neighbourhood within the 3x3 block around a cell.
+static bool isNeighbor(Neighborhood n, bool odd_row, int dx, int dy) {
+    if (dx == 0 && dy == 0) return false;
+    switch (n) {
+        case Neighborhood::VonNeumann: return dx == 0 || dy == 0;
+        case Neighborhood::Hex:        return dy == 0 || dx != (odd_row ? -1 : 1);
+        default:                       return true;
+    }
+}
+
+struct NeighborTable {
+    int count = 0;
+    int dx[8] = {};
+    int dy[8] = {};
+};
+
+static NeighborTable neighborTable(Neighborhood n, bool odd_row) {
+    NeighborTable t;
     for (int dy = -1; dy <= 1; ++dy) {
         for (int dx = -1; dx <= 1; ++dx) {
-            if (dx == 0 && dy == 0) continue;
-            int nx = x + dx, ny = y + dy;
-            if (wrap) {
-                nx = mod(nx, w);
-                ny = mod(ny, h);
-                c += g[idx(nx, ny, w)] ? 1 : 0;
-            } else {
-                if (nx < 0 || nx >= w || ny < 0 || ny >= h) continue;
-                c += g[idx(nx, ny, w)] ? 1 : 0;
-            }
+            if (!isNeighbor(n, odd_row, dx, dy)) continue;
+            t.dx[t.count] = dx;
+            t.dy[t.count] = dy;
+            ++t.count;
+        }
+    }
+    return t;
+}
+
+static int countNeighbors(const std::vector<uint8_t>& g, int x, int y, int w, int h, bool wrap,
+                          const NeighborTable& t) {
+    int c = 0;
+    for (int k = 0; k < t.count; ++k) {
+        int nx = x + t.dx[k], ny = y + t.dy[k];
+        if (wrap) {
+            nx = mod(nx, w);
+            ny = mod(ny, h);
+            c += g[idx(nx, ny, w)] ? 1 : 0;
+        } else {
+            if (nx < 0 || nx >= w || ny < 0 || ny >= h) continue;
+            c += g[idx(nx, ny, w)] ? 1 : 0;
         }
     }
     return c;
 }
 
-static void stepLife(const std::vector<uint8_t>& cur, std::vector<uint8_t>& nxt,
-                     int w, int h, bool wrap, int max_age) {
+// Stochastic rules (--birth-p, --survive-p, --noise): a birth or survival the rule grants happens
+// only with its probability, and a cell the rule leaves dead is born anyway with the noise
+// probability. Each cell's draw is a counter-based hash of (seed, generation, row, column), so a
+// generation does not depend on how rows were split across threads or on anything stepped before.
+// The dense kernel hashes kNoiseBlock cells at a time, four lanes per SSE2 or NEON instruction
+// (scalar elsewhere); the reference kernel hashes cell by cell with noiseDraw.
+struct StepNoise {
+    uint64_t seed = 0;
+    uint64_t generation = 0;              // the generation being computed
+    uint32_t birth = 0, survive = 0, spont = 0; // thresholds for the 24-bit draws
+};
+
+static constexpr int kNoiseBlock = 64;
+
+static bool isStochastic(const Config& c) { return c.birth_p < 1.0 || c.survive_p < 1.0 || c.noise > 0.0; }
+
+static uint32_t noiseThreshold(double p) { return (uint32_t)std::llround(std::clamp(p, 0.0, 1.0) * (1 << 24)); }
+
+static StepNoise stepNoise(const Config& c, uint64_t seed, uint64_t generation) {
+    return StepNoise{seed, generation, noiseThreshold(c.birth_p), noiseThreshold(c.survive_p), noiseThreshold(c.noise)};
+}
+
+static inline uint64_t noiseRowKey(const StepNoise& n, int y) {
+    return avalanche64(hashRound(hashRound(kP5 + n.seed, n.generation), (uint64_t)y));
+}
+
+static inline uint32_t lowbias32(uint32_t v) {
+    v ^= v >> 16;
+    v *= 0x7feb352du;
+    v ^= v >> 15;
+    v *= 0x846ca68bu;
+    v ^= v >> 16;
+    return v;
+}
+
+// Uniform 24-bit draw of cell x in the row with this key.
+static inline uint32_t noiseDraw(uint64_t key, int x) {
+    return lowbias32(lowbias32((uint32_t)x + (uint32_t)key) ^ (uint32_t)(key >> 32)) >> 8;
+}
+
+#if defined(CONWAY_SSE2)
+// SSE2 has no 32-bit low multiply (pmulld is SSE4.1): without it, multiply the even and odd lanes
+// as 64-bit products and gather their low halves.
+static inline __m128i mul32x4(__m128i a, __m128i k) {
+#ifdef __SSE4_1__
+    return _mm_mullo_epi32(a, k);
+#else
+    __m128i even = _mm_mul_epu32(a, k);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), k);
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+                              _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+
+static inline __m128i lowbias32x4(__m128i v) {
+    v = _mm_xor_si128(v, _mm_srli_epi32(v, 16));
+    v = mul32x4(v, _mm_set1_epi32((int)0x7feb352du));
+    v = _mm_xor_si128(v, _mm_srli_epi32(v, 15));
+    v = mul32x4(v, _mm_set1_epi32((int)0x846ca68bu));
+    return _mm_xor_si128(v, _mm_srli_epi32(v, 16));
+}
+
+static void noiseBlock(uint64_t key, int base, uint32_t* out) {
+    const __m128i lo = _mm_set1_epi32((int)(uint32_t)key), hi = _mm_set1_epi32((int)(uint32_t)(key >> 32));
+    __m128i x = _mm_add_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(base));
+    for (int i = 0; i < kNoiseBlock; i += 4) {
+        __m128i v = lowbias32x4(_mm_xor_si128(lowbias32x4(_mm_add_epi32(x, lo)), hi));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_srli_epi32(v, 8));
+        x = _mm_add_epi32(x, _mm_set1_epi32(4));
+    }
+}
+#elif defined(CONWAY_NEON)
+static inline uint32x4_t lowbias32x4(uint32x4_t v) {
+    v = veorq_u32(v, vshrq_n_u32(v, 16));
+    v = vmulq_n_u32(v, 0x7feb352du);
+    v = veorq_u32(v, vshrq_n_u32(v, 15));
+    v = vmulq_n_u32(v, 0x846ca68bu);
+    return veorq_u32(v, vshrq_n_u32(v, 16));
+}
+
+static void noiseBlock(uint64_t key, int base, uint32_t* out) {
+    static const uint32_t lanes[4] = {0, 1, 2, 3};
+    const uint32x4_t lo = vdupq_n_u32((uint32_t)key), hi = vdupq_n_u32((uint32_t)(key >> 32));
+    uint32x4_t x = vaddq_u32(vld1q_u32(lanes), vdupq_n_u32((uint32_t)base));
+    for (int i = 0; i < kNoiseBlock; i += 4) {
+        uint32x4_t v = lowbias32x4(veorq_u32(lowbias32x4(vaddq_u32(x, lo)), hi));
+        vst1q_u32(out + i, vshrq_n_u32(v, 8));
+        x = vaddq_u32(x, vdupq_n_u32(4));
+    }
+}
+#else
+static void noiseBlock(uint64_t key, int base, uint32_t* out) {
+    for (int i = 0; i < kNoiseBlock; ++i) out[i] = noiseDraw(key, base + i);
+}
+#endif
+
+static inline bool noisyNext(const StepNoise& n, bool alive, bool rule_next, uint32_t draw) {
+    return draw < (rule_next ? (alive ? n.survive : n.birth) : n.spont);
+}
+
+static inline uint8_t nextAge(uint8_t age, bool next_alive, uint8_t cap) {
+    if (!next_alive) return 0;
+    if (!age) return 1;
+    return (age < cap) ? (uint8_t)(age + 1) : cap;
+}
+
+// Straightforward kernel driven by a runtime offset table; --verify checks the specialised
+// kernels and the runs engine against it. Returns the live-cell count of the new generation and
+// flags tiles whose liveness changed.
+static uint64_t stepLifeReference(const std::vector<uint8_t>& cur, std::vector<uint8_t>& nxt, int w, int h,
+                                  bool wrap, int max_age, Neighborhood nb, Rule rule, TileGrid& tiles,
+                                  const StepNoise* noise = nullptr) {
     uint8_t cap = (uint8_t)std::clamp(max_age, 1, 255);
+    uint64_t population = 0;
+    const NeighborTable tables[2] = {neighborTable(nb, false), neighborTable(nb, true)};
 
     for (int y = 0; y < h; ++y) {
+        uint8_t* changed = &tiles.changed[(size_t)(y >> kTileShift) * tiles.tiles_x];
+        const uint64_t key = noise ? noiseRowKey(*noise, y) : 0;
         for (int x = 0; x < w; ++x) {
             int i = idx(x, y, w);
-            int n = countNeighbors(cur, x, y, w, h, wrap);
+            int n = countNeighbors(cur, x, y, w, h, wrap, tables[y & 1]);
 
             uint8_t age = cur[i];
             bool alive = (age != 0);
 
-            bool nextAlive = alive ? (n == 2 || n == 3) : (n == 3);
+            bool nextAlive = ((alive ? rule.survive : rule.birth) >> n) & 1;
+            if (noise) nextAlive = noisyNext(*noise, alive, nextAlive, noiseDraw(key, x));
+            if (nextAlive != alive) changed[x >> kTileShift] = 1;
 
-            if (!nextAlive) {
-                nxt[i] = 0;
-            } else {
-                if (!alive) nxt[i] = 1;
-                else        nxt[i] = (age < cap) ? (uint8_t)(age + 1) : cap;
+            nxt[i] = nextAge(age, nextAlive, cap);
+            if (nextAlive) ++population;
+        }
+    }
+    return population;
+}
+
+// Compile-time neighbour offsets for the specialised kernels; one instantiation per
+// neighbourhood and row parity, so the inner loop unrolls to fixed loads.
+template <Neighborhood N, bool OddRow> struct Stencil;
+
+template <bool OddRow> struct Stencil<Neighborhood::Moore, OddRow> {
+    static constexpr int kCount = 8;
+    static constexpr int dx[kCount] = {-1, 0, 1, -1, 1, -1, 0, 1};
+    static constexpr int dy[kCount] = {-1, -1, -1, 0, 0, 1, 1, 1};
+};
+
+template <bool OddRow> struct Stencil<Neighborhood::VonNeumann, OddRow> {
+    static constexpr int kCount = 4;
+    static constexpr int dx[kCount] = {0, -1, 1, 0};
+    static constexpr int dy[kCount] = {-1, 0, 0, 1};
+};
+
+template <bool OddRow> struct Stencil<Neighborhood::Hex, OddRow> {
+    static constexpr int kCount = 6;
+    static constexpr int dx[kCount] = {OddRow ? 0 : -1, OddRow ? 1 : 0, -1, 1, OddRow ? 0 : -1, OddRow ? 1 : 0};
+    static constexpr int dy[kCount] = {-1, -1, 0, 0, 1, 1};
+};
+
+// Columns [x0, x1) of one row of the specialised kernel. rows[0..2] are the rows above, at and below
+// y; a missing row (bounded universe) is nullptr and sends the whole row down the checked path.
+// Noisy rows draw from `noise` with the row's key, a block of kNoiseBlock cells at a time.
+template <Neighborhood N, bool OddRow, bool Noisy>
+static uint64_t stepRowDense(const uint8_t* const rows[3], uint8_t* out, int w, int x0, int x1, bool wrap, Rule rule,
+                             uint8_t cap, uint8_t* changed, const StepNoise* noise, uint64_t key) {
+    using S = Stencil<N, OddRow>;
+    const uint8_t* mid = rows[1];
+    uint64_t population = 0;
+    uint32_t draws[Noisy ? kNoiseBlock : 1];
+    int base = -kNoiseBlock;
+
+    auto apply = [&](int x, int n) {
+        uint8_t age = mid[x];
+        bool alive = age != 0;
+        bool next = ((alive ? rule.survive : rule.birth) >> n) & 1;
+        if constexpr (Noisy) {
+            if ((unsigned)(x - base) >= (unsigned)kNoiseBlock) {
+                base = x & ~(kNoiseBlock - 1);
+                noiseBlock(key, base, draws);
             }
+            next = noisyNext(*noise, alive, next, draws[x - base]);
+        }
+        if (next != alive) changed[x >> kTileShift] = 1;
+        out[x] = nextAge(age, next, cap);
+        population += next;
+    };
+    auto checked = [&](int x) {
+        int n = 0;
+        for (int k = 0; k < S::kCount; ++k) {
+            const uint8_t* r = rows[S::dy[k] + 1];
+            int nx = x + S::dx[k];
+            if (wrap) nx = mod(nx, w);
+            else if (nx < 0 || nx >= w) continue;
+            if (r) n += r[nx] != 0;
+        }
+        apply(x, n);
+    };
+
+    if (!rows[0] || !rows[2]) {
+        for (int x = x0; x < x1; ++x) checked(x);
+        return population;
+    }
+    if (x0 == 0) checked(0);
+    const int lo = std::max(x0, 1), hi = std::min(x1, w - 1);
+    for (int x = lo; x < hi; ++x) {
+        int n = 0;
+        for (int k = 0; k < S::kCount; ++k) n += rows[S::dy[k] + 1][x + S::dx[k]] != 0;
+        apply(x, n);
+    }
+    if (x1 == w && w > 1) checked(w - 1);
+    return population;
+}
+
+template <Neighborhood N>
+static uint64_t stepLifeN(const std::vector<uint8_t>& cur, std::vector<uint8_t>& nxt, int w, int h, int y0, int y1,
+                          int x0, int x1, bool wrap, int max_age, Rule rule, TileGrid& tiles, uint16_t* activity,
+                          const StepNoise* noise) {
+    uint8_t cap = (uint8_t)std::clamp(max_age, 1, 255);
+    uint64_t population = 0;
+    for (int y = y0; y < y1; ++y) {
+        int ya = y - 1, yb = y + 1;
+        if (wrap) {
+            ya = mod(ya, h);
+            yb = mod(yb, h);
+        }
+        const uint8_t* rows[3] = {
+            (ya >= 0 && ya < h) ? cur.data() + (size_t)ya * w : nullptr,
+            cur.data() + (size_t)y * w,
+            (yb >= 0 && yb < h) ? cur.data() + (size_t)yb * w : nullptr,
+        };
+        uint8_t* out = nxt.data() + (size_t)y * w;
+        uint8_t* changed = &tiles.changed[(size_t)(y >> kTileShift) * tiles.tiles_x];
+        if (noise) {
+            uint64_t key = noiseRowKey(*noise, y);
+            population += (y & 1) ? stepRowDense<N, true, true>(rows, out, w, x0, x1, wrap, rule, cap, changed, noise, key)
+                                  : stepRowDense<N, false, true>(rows, out, w, x0, x1, wrap, rule, cap, changed, noise, key);
+        } else {
+            population += (y & 1) ? stepRowDense<N, true, false>(rows, out, w, x0, x1, wrap, rule, cap, changed, nullptr, 0)
+                                  : stepRowDense<N, false, false>(rows, out, w, x0, x1, wrap, rule, cap, changed, nullptr, 0);
+        }
+        if (activity) accumulateActivity(rows[1], out, activity + (size_t)y * w, x0, x1);
+    }
+    return population;
+}
+
+// Steps rows [y0, y1) into nxt. Returns the live-cell count of those rows in the new generation;
+// flags tiles whose liveness changed. Row bands that start on a tile row can run concurrently.
+// With `cost` (one slot per tile column), the band is stepped a tile at a time and each tile's time
+// is added to its slot.
+// With `activity` (one counter per cell), each row's flips are counted right after it is stepped.
+// With `noise`, the rule is applied stochastically.
+static uint64_t stepLife(const std::vector<uint8_t>& cur, std::vector<uint8_t>& nxt, int w, int h, int y0, int y1,
+                         bool wrap, int max_age, Neighborhood nb, Rule rule, TileGrid& tiles,
+                         uint64_t* cost = nullptr, uint16_t* activity = nullptr, const StepNoise* noise = nullptr) {
+    auto columns = [&](int x0, int x1) -> uint64_t {
+        switch (nb) {
+            case Neighborhood::VonNeumann:
+                return stepLifeN<Neighborhood::VonNeumann>(cur, nxt, w, h, y0, y1, x0, x1, wrap, max_age, rule, tiles,
+                                                           activity, noise);
+            case Neighborhood::Hex:
+                return stepLifeN<Neighborhood::Hex>(cur, nxt, w, h, y0, y1, x0, x1, wrap, max_age, rule, tiles,
+                                                    activity, noise);
+            default:
+                return stepLifeN<Neighborhood::Moore>(cur, nxt, w, h, y0, y1, x0, x1, wrap, max_age, rule, tiles,
+                                                      activity, noise);
         }
+    };
+    if (!cost) return columns(0, w);
+    uint64_t population = 0;
+    for (int x0 = 0; x0 < w; x0 += kTileSize) {
+        auto t0 = std::chrono::steady_clock::now();
+        population += columns(x0, std::min(w, x0 + kTileSize));
+        cost[x0 >> kTileShift] += elapsedNs(t0, std::chrono::steady_clock::now());
     }
+    return population;
 }
 
+// ---------------- Grid ----------------
+
 static void randomize(std::vector<uint8_t>& g, double density, std::mt19937& rng) {
     std::bernoulli_distribution d(std::clamp(density, 0.0, 1.0));
     for (auto& cell : g) cell = d(rng) ? 1 : 0;
 }
 
+// Continuous states: squares of side 2 * radius, each filled with uniform random states with
+// probability 2 * density.
+static void randomizeBlocks(std::vector<uint8_t>& g, int w, int h, int radius, double density, std::mt19937& rng) {
+    std::fill(g.begin(), g.end(), 0);
+    const int side = std::max(2, 2 * radius);
+    std::bernoulli_distribution seeded(std::clamp(2.0 * density, 0.0, 1.0));
+    std::uniform_int_distribution<int> level(0, 255);
+    for (int by = 0; by < h; by += side) {
+        for (int bx = 0; bx < w; bx += side) {
+            if (!seeded(rng)) continue;
+            for (int y = by; y < std::min(h, by + side); ++y) {
+                for (int x = bx; x < std::min(w, bx + side); ++x) g[idx(x, y, w)] = (uint8_t)level(rng);
+            }
+        }
+    }
+}
+
 static void setCell(std::vector<uint8_t>& g, int w, int h, int gx, int gy, bool alive) {
     if (gx < 0 || gx >= w || gy < 0 || gy >= h) return;
     g[idx(gx, gy, w)] = alive ? 1 : 0;
 }
 
-static void resizeGridToWindow(SDL_Window* win, const Config& cfg,
-                               int& grid_w, int& grid_h,
-                               std::vector<uint8_t>& cur, std::vector<uint8_t>& nxt) {
-    int win_w_px = 0, win_h_px = 0;
-    SDL_GetWindowSize(win, &win_w_px, &win_h_px);
+// Reserve room for a grid covering a window of up to win_w_px x win_h_px, so later resizes
+// within that size reuse the buffers instead of allocating.
+static void reserveGrid(const Config& cfg, int win_w_px, int win_h_px,
+                        std::vector<uint8_t>& cur, std::vector<uint8_t>& nxt) {
+    int cell = std::max(1, cfg.cell_px);
+    size_t cells = (size_t)std::max(1, win_w_px / cell) * (size_t)std::max(1, win_h_px / cell);
+    cur.reserve(cells);
+    if (cfg.engine != Engine::Runs) nxt.reserve(cells);
+}
+
+// Largest even 2^a 3^b 5^c <= n (at least 2): the Lenia engine's FFT lengths.
+static int fftSize(int n) {
+    for (int m = std::max(2, n) & ~1; m > 2; m -= 2) {
+        int r = m;
+        for (int p : {2, 3, 5}) while (r % p == 0) r /= p;
+        if (r == 1) return m;
+    }
+    return 2;
+}
 
+static void resizeGrid(const Config& cfg, int win_w_px, int win_h_px,
+                       int& grid_w, int& grid_h,
+                       std::vector<uint8_t>& cur, std::vector<uint8_t>& nxt) {
     int cell = std::max(1, cfg.cell_px);
     int new_w = std::max(1, win_w_px / cell);
     int new_h = std::max(1, win_h_px / cell);
+    if (cfg.engine == Engine::Lenia) {
+        new_w = fftSize(new_w);
+        new_h = fftSize(new_h);
+    }
 
     if (new_w == grid_w && new_h == grid_h && (int)cur.size() == grid_w * grid_h) return;
 
-    std::vector<uint8_t> new_cur(new_w * new_h, 0);
-    std::vector<uint8_t> new_nxt(new_w * new_h, 0);
-
+    // Re-layout cur in place (no scratch grid, so engines without a dense nxt stay single-buffer).
+    // Narrower rows move toward the front, so copy forward; wider rows move back, so copy backward.
+    // resize()/assign() only allocate when the grid outgrows the reserved capacity.
+    size_t cells = (size_t)new_w * (size_t)new_h;
     bool old_ok = (grid_w > 0 && grid_h > 0 && (int)cur.size() == grid_w * grid_h);
-    if (old_ok) {
+    if (!old_ok) {
+        cur.assign(cells, 0);
+    } else {
         int copy_w = std::min(grid_w, new_w);
         int copy_h = std::min(grid_h, new_h);
-        for (int y = 0; y < copy_h; ++y) {
-            for (int x = 0; x < copy_w; ++x) {
-                new_cur[idx(x, y, new_w)] = cur[idx(x, y, grid_w)];
+        if (new_w <= grid_w) {
+            for (int y = 0; y < copy_h; ++y) {
+                std::memmove(&cur[idx(0, y, new_w)], &cur[idx(0, y, grid_w)], (size_t)copy_w);
+            }
+        } else {
+            cur.resize(std::max(cells, cur.size()));
+            for (int y = copy_h - 1; y >= 0; --y) {
+                std::memmove(&cur[idx(0, y, new_w)], &cur[idx(0, y, grid_w)], (size_t)copy_w);
+                std::memset(&cur[idx(copy_w, y, new_w)], 0, (size_t)(new_w - copy_w));
             }
         }
+        cur.resize(cells);
+        std::fill(cur.begin() + (size_t)copy_h * new_w, cur.end(), 0);
     }
 
     grid_w = new_w;
     grid_h = new_h;
-    cur.swap(new_cur);
-    nxt.swap(new_nxt);
+    if (cfg.engine != Engine::Runs) nxt.assign(cells, 0);
+}
+
+// ---------------- Object census ----------------
+//
+// --census and O count the objects on a universe and name the common ones, in an overlay and in the
+// exit report. An object is a cluster of live cells at most two apart in x and in y: cells whose
+// neighbourhoods overlap can interact, and the two halves of a toad or beacon in their sparse phase,
+// or the loose cell of a spaceship, stay in one cluster. Clusters up to kShapeSpan cells across are
+// named by shape, translated to their bounding box, from a table of the known B3/S23 objects through
+// their periods in all eight orientations. Other rules are counted, not named.
+//
+// The census follows the tiles' change flags, so tiles unchanged since the previous census cost
+// nothing:
+//   round 0, a chunk per tile row: changed tiles are labelled again by a union-find over their cells,
+//     and each of their clusters is named as if it were whole;
+//   round 1: around the changed tiles, the pairs of clusters that meet across tile edges are listed;
+//   finish: a union-find over all tiles' clusters joins the listed pairs. Joined clusters are named
+//     from their cells, the others keep their tile's answer, so the finish is linear in the number of
+//     clusters rather than cells.
+
+enum class ObjectKind : uint8_t { StillLife, Oscillator, Spaceship };
+static constexpr int kObjectKinds = 3;
+
+static const char* objectKindName(ObjectKind k) {
+    switch (k) {
+        case ObjectKind::Oscillator: return "oscillators";
+        case ObjectKind::Spaceship:  return "spaceships";
+        default:                     return "still lifes";
+    }
+}
+
+struct KnownObject {
+    const char* name;
+    ObjectKind kind;
+    int period;
+    const char* cells; // one phase, plaintext rows separated by '/'
+};
+
+// The commonest objects of random B3/S23 soups, roughly by frequency within each kind.
+static constexpr KnownObject kKnownObjects[] = {
+    {"block", ObjectKind::StillLife, 1, "OO/OO"},
+    {"beehive", ObjectKind::StillLife, 1, ".OO./O..O/.OO."},
+    {"loaf", ObjectKind::StillLife, 1, ".OO./O..O/.O.O/..O."},
+    {"boat", ObjectKind::StillLife, 1, "OO./O.O/.O."},
+    {"ship", ObjectKind::StillLife, 1, "OO./O.O/.OO"},
+    {"tub", ObjectKind::StillLife, 1, ".O./O.O/.O."},
+    {"pond", ObjectKind::StillLife, 1, ".OO./O..O/O..O/.OO."},
+    {"long boat", ObjectKind::StillLife, 1, "OO../O.O./.O.O/..O."},
+    {"barge", ObjectKind::StillLife, 1, ".O../O.O./.O.O/..O."},
+    {"mango", ObjectKind::StillLife, 1, ".OO../O..O./.O..O/..OO."},
+    {"eater", ObjectKind::StillLife, 1, "OO../O.O./..O./..OO"},
+    {"snake", ObjectKind::StillLife, 1, "OO.O/O.OO"},
+    {"carrier", ObjectKind::StillLife, 1, "OO../O..O/..OO"},
+    {"blinker", ObjectKind::Oscillator, 2, "OOO"},
+    {"toad", ObjectKind::Oscillator, 2, ".OOO/OOO."},
+    {"beacon", ObjectKind::Oscillator, 2, "OO../OO../..OO/..OO"},
+    {"pulsar", ObjectKind::Oscillator, 3,
+     "..OOO...OOO../............./O....O.O....O/O....O.O....O/O....O.O....O/..OOO...OOO../"
+     "............./..OOO...OOO../O....O.O....O/O....O.O....O/O....O.O....O/............./..OOO...OOO.."},
+    {"glider", ObjectKind::Spaceship, 4, ".O./..O/OOO"},
+    {"lwss", ObjectKind::Spaceship, 4, ".O..O/O..../O...O/OOOO."},
+    {"mwss", ObjectKind::Spaceship, 4, "...O../.O...O/O...../O....O/OOOOO."},
+    {"hwss", ObjectKind::Spaceship, 4, "...OO../.O....O/O....../O.....O/OOOOOO."},
+};
+static constexpr int kKnownObjectCount = (int)std::size(kKnownObjects);
+
+static constexpr int kShapeSpan = 16;
+
+// Up to kShapeSpan x kShapeSpan cells: bit x of rows[y].
+struct Shape {
+    int w = 0, h = 0;
+    std::array<uint16_t, kShapeSpan> rows{};
+};
+
+// Shape t of the eight rotations and reflections of s (0 is s itself).
+static Shape orientShape(const Shape& s, int t) {
+    const bool flip_x = t & 1, flip_y = t & 2, transpose = t & 4;
+    Shape o;
+    o.w = transpose ? s.h : s.w;
+    o.h = transpose ? s.w : s.h;
+    for (int y = 0; y < s.h; ++y) {
+        for (int x = 0; x < s.w; ++x) {
+            if (!(s.rows[(size_t)y] >> x & 1)) continue;
+            int u = flip_x ? s.w - 1 - x : x, v = flip_y ? s.h - 1 - y : y;
+            if (transpose) std::swap(u, v);
+            o.rows[(size_t)v] |= (uint16_t)(1u << u);
+        }
+    }
+    return o;
+}
+
+static uint64_t shapeHash(const Shape& s) {
+    uint64_t h = hashRound(kP1, ((uint64_t)s.w << 8) | (uint64_t)s.h);
+    for (int y = 0; y < s.h; y += 4) {
+        uint64_t word = 0;
+        for (int k = 0; k < 4 && y + k < s.h; ++k) word |= (uint64_t)s.rows[(size_t)(y + k)] << (16 * k);
+        h = hashRound(h, word);
+    }
+    return avalanche64(h);
+}
+
+// Hashes of every phase of every known object in every orientation, built on first use, so a cluster
+// is looked up as it lies.
+class ObjectTable {
+public:
+    static const ObjectTable& get() {
+        static const ObjectTable table;
+        return table;
+    }
+
+    // Index into kKnownObjects, or -1.
+    int find(uint64_t hash) const {
+        auto it = std::lower_bound(shapes_.begin(), shapes_.end(), std::make_pair(hash, -1));
+        return it != shapes_.end() && it->first == hash ? it->second : -1;
+    }
+
+private:
+    ObjectTable() {
+        constexpr int kPad = 4; // spaceships move at most 2 cells in their period
+        for (int i = 0; i < kKnownObjectCount; ++i) {
+            const KnownObject& o = kKnownObjects[i];
+            int w = 0, h = 1, x = 0;
+            for (const char* p = o.cells; *p; ++p) {
+                if (*p == '/') ++h, x = 0;
+                else w = std::max(w, ++x);
+            }
+            const int gw = w + 2 * kPad, gh = h + 2 * kPad;
+            std::vector<uint8_t> cur((size_t)gw * gh, 0), nxt(cur.size(), 0);
+            x = 0;
+            int y = 0;
+            for (const char* p = o.cells; *p; ++p) {
+                if (*p == '/') ++y, x = 0;
+                else cur[(size_t)idx(kPad + x++, kPad + y, gw)] = *p == 'O';
+            }
+            TileGrid tiles;
+            tiles.resize(gw, gh);
+            for (int phase = 0; phase < o.period; ++phase) {
+                Shape s;
+                if (shapeOf(cur, gw, gh, s)) {
+                    for (int t = 0; t < 8; ++t) shapes_.emplace_back(shapeHash(orientShape(s, t)), i);
+                }
+                stepLifeReference(cur, nxt, gw, gh, false, 1, Neighborhood::Moore, Rule{}, tiles);
+                cur.swap(nxt);
+            }
+        }
+        std::sort(shapes_.begin(), shapes_.end());
+        shapes_.erase(std::unique(shapes_.begin(), shapes_.end()), shapes_.end());
+    }
+
+    static bool shapeOf(const std::vector<uint8_t>& g, int w, int h, Shape& s) {
+        int x0 = w, y0 = h, x1 = -1, y1 = -1;
+        for (int y = 0; y < h; ++y) {
+            for (int x = 0; x < w; ++x) {
+                if (!g[(size_t)idx(x, y, w)]) continue;
+                x0 = std::min(x0, x), x1 = std::max(x1, x);
+                y0 = std::min(y0, y), y1 = std::max(y1, y);
+            }
+        }
+        s.w = x1 - x0 + 1;
+        s.h = y1 - y0 + 1;
+        if (x1 < 0 || s.w > kShapeSpan || s.h > kShapeSpan) return false;
+        for (int y = y0; y <= y1; ++y) {
+            for (int x = x0; x <= x1; ++x) {
+                if (g[(size_t)idx(x, y, w)]) s.rows[(size_t)(y - y0)] |= (uint16_t)(1u << (x - x0));
+            }
+        }
+        return true;
+    }
+
+    std::vector<std::pair<uint64_t, int>> shapes_;
+};
+
+// Glyph pixels the census overlay can draw in a frame; more are dropped.
+static constexpr size_t kCensusTextRects = 16384;
+
+class ObjectCensus {
+public:
+    // Cells of different clusters are at least three apart, which bounds the clusters in a tile.
+    static constexpr int kMaxClusters = ((kTileSize + 2) / 3) * ((kTileSize + 2) / 3);
+    static constexpr int kMaxPairs = 256; // listed per tile; beyond that the finish rescans its edges
+
+    // Counts of the latest census.
+    uint64_t objects = 0;
+    std::array<uint64_t, kObjectKinds> by_kind{};
+    uint64_t unnamed = 0;
+    std::array<uint64_t, kKnownObjectCount> by_name{};
+    bool named = false; // B3/S23 on the square grid
+
+    void reserve(int max_w, int max_h) {
+        const size_t tiles = (size_t)((max_w + kTileSize - 1) >> kTileShift) * ((max_h + kTileSize - 1) >> kTileShift);
+        label_.reserve((size_t)max_w * max_h);
+        clusters_.reserve(tiles * kMaxClusters);
+        cluster_count_.reserve(tiles);
+        pairs_.reserve(tiles * kMaxPairs);
+        pair_count_.reserve(tiles);
+        pair_overflow_.reserve(tiles);
+        for (auto* flags : {&dirty_, &stepped_, &relabel_, &relist_}) flags->reserve(tiles);
+        base_.reserve(tiles + 1);
+        parent_.reserve(tiles * kMaxClusters);
+        next_.reserve(tiles * kMaxClusters);
+        scratch_.reserve((size_t)((max_h + kTileSize - 1) >> kTileShift) * kScratch);
+        (void)ObjectTable::get();
+    }
+
+    // Every tile is labelled again at the next census.
+    void resize(int w, int h, const Config& c) {
+        w_ = w;
+        h_ = h;
+        wrap_ = c.wrap;
+        named = c.neighborhood == Neighborhood::Moore && c.rule.birth == Rule{}.birth && c.rule.survive == Rule{}.survive;
+        tiles_x_ = (w + kTileSize - 1) >> kTileShift;
+        tiles_y_ = (h + kTileSize - 1) >> kTileShift;
+        const size_t tiles = (size_t)tiles_x_ * tiles_y_;
+        label_.assign((size_t)w * h, 0);
+        clusters_.resize(tiles * kMaxClusters);
+        cluster_count_.assign(tiles, 0);
+        pairs_.resize(tiles * kMaxPairs);
+        pair_count_.assign(tiles, 0);
+        pair_overflow_.assign(tiles, 0);
+        dirty_.assign(tiles, 1);
+        stepped_.assign(tiles, 0);
+        relabel_.assign(tiles, 0);
+        relist_.assign(tiles, 0);
+        base_.assign(tiles + 1, 0);
+        scratch_.resize((size_t)tiles_y_ * kScratch);
+    }
+
+    // Pool, from the step's finish: the tiles whose liveness changed.
+    void noteStep(const std::vector<uint8_t>& changed) {
+        for (size_t t = 0; t < stepped_.size(); ++t) stepped_[t] |= changed[t];
+    }
+    // Main thread, when the step is published; and for painted cells.
+    void publish() {
+        for (size_t t = 0; t < dirty_.size(); ++t) dirty_[t] |= std::exchange(stepped_[t], 0);
+    }
+    void mark(int x, int y) { dirty_[(size_t)(y >> kTileShift) * tiles_x_ + (x >> kTileShift)] = 1; }
+
+    bool due() const { return std::find(dirty_.begin(), dirty_.end(), 1) != dirty_.end(); }
+
+    // Main thread, before submitting: takes the dirty tiles and works out whose edge pairs they touch.
+    // A tile lists the pairs to its left, right and lower neighbours, so a changed tile invalidates
+    // those of its upper, left and right neighbours. Tiles of one cell (the last row or column of a
+    // wrapped grid) let pairs skip a tile, so then every tile is listed again.
+    void begin() {
+        relabel_.swap(dirty_);
+        std::fill(dirty_.begin(), dirty_.end(), 0);
+        std::fill(relist_.begin(), relist_.end(), 0);
+        const bool thin = wrap_ && ((w_ & (kTileSize - 1)) == 1 || (h_ & (kTileSize - 1)) == 1);
+        for (int ty = 0; ty < tiles_y_; ++ty) {
+            for (int tx = 0; tx < tiles_x_; ++tx) {
+                if (!relabel_[(size_t)ty * tiles_x_ + tx]) continue;
+                if (thin) {
+                    std::fill(relist_.begin(), relist_.end(), 1);
+                    break;
+                }
+                for (int dy = -1; dy <= 0; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        int nx = tx + dx, ny = ty + dy;
+                        if (wrap_) nx = mod(nx, tiles_x_), ny = mod(ny, tiles_y_);
+                        else if (nx < 0 || nx >= tiles_x_ || ny < 0) continue;
+                        relist_[(size_t)ny * tiles_x_ + nx] = 1;
+                    }
+                }
+            }
+        }
+        round_ = 0;
+    }
+
+    int rows() const { return tiles_y_; }
+    void nextRound() { ++round_; }
+
+    // One tile row of the current round.
+    void run(const std::vector<uint8_t>& g, int ty) {
+        for (int tx = 0; tx < tiles_x_; ++tx) {
+            const size_t t = (size_t)ty * tiles_x_ + tx;
+            if (round_ == 0 && relabel_[t]) labelTile(g, tx, ty);
+            if (round_ == 1 && relist_[t]) listPairs(g, tx, ty);
+        }
+    }
+
+    void finish(const std::vector<uint8_t>& g) {
+        const size_t tiles = cluster_count_.size();
+        for (size_t t = 0; t < tiles; ++t) base_[t + 1] = base_[t] + cluster_count_[t];
+        const uint32_t nodes = base_[tiles];
+        parent_.resize(nodes);
+        next_.resize(nodes);
+        for (uint32_t i = 0; i < nodes; ++i) parent_[i] = next_[i] = i;
+        for (int ty = 0; ty < tiles_y_; ++ty) {
+            for (int tx = 0; tx < tiles_x_; ++tx) {
+                const size_t t = (size_t)ty * tiles_x_ + tx;
+                auto join = [&](uint16_t a, uint32_t other, uint16_t b) { unite(base_[t] + a - 1, base_[other] + b - 1); };
+                const Pair* p = pairs_.data() + t * kMaxPairs;
+                for (int k = 0; k < pair_count_[t]; ++k) join(p[k].a, p[k].tile, p[k].b);
+                if (pair_overflow_[t]) forEachPair(g, tx, ty, join);
+            }
+        }
+
+        objects = unnamed = 0;
+        by_kind.fill(0);
+        by_name.fill(0);
+        const ObjectTable& table = ObjectTable::get();
+        for (size_t t = 0; t < tiles; ++t) {
+            for (int c = 0; c < cluster_count_[t]; ++c) {
+                const uint32_t i = base_[t] + (uint32_t)c;
+                if (parent_[i] != i) continue;
+                int known = clusters_[t * kMaxClusters + (size_t)c].known;
+                if (next_[i] != i) known = named ? identifyJoined(i, table) : -1;
+                ++objects;
+                if (known < 0) {
+                    ++unnamed;
+                } else {
+                    ++by_name[(size_t)known];
+                    ++by_kind[(size_t)kKnownObjects[known].kind];
+                }
+            }
+        }
+    }
+
+    size_t bytes() const {
+        return label_.capacity() * sizeof(uint16_t) + clusters_.capacity() * sizeof(Cluster) +
+               pairs_.capacity() * sizeof(Pair) + (parent_.capacity() + next_.capacity() + base_.capacity()) * sizeof(uint32_t) +
+               scratch_.capacity() * sizeof(uint16_t) + cluster_count_.capacity() * sizeof(uint16_t) +
+               pair_count_.capacity() * sizeof(uint16_t) + 5 * dirty_.capacity();
+    }
+    static uint64_t estimateBytes(uint64_t w, uint64_t h) {
+        const uint64_t tiles = ((w + kTileSize - 1) >> kTileShift) * ((h + kTileSize - 1) >> kTileShift);
+        return w * h * sizeof(uint16_t) + tiles * (kMaxClusters * (sizeof(Cluster) + 2 * sizeof(uint32_t)) +
+               kMaxPairs * sizeof(Pair) + 13) + ((h + kTileSize - 1) >> kTileShift) * kScratch * sizeof(uint16_t);
+    }
+
+private:
+    static constexpr size_t kScratch = 2 * ((size_t)kTileSize * kTileSize + 1); // per tile row: parents, ids
+
+    struct Cluster {
+        uint16_t cells;
+        uint8_t x0, y0, x1, y1; // within the tile
+        int16_t known;          // kKnownObjects index if the cluster is whole, or -1
+    };
+    struct Pair {
+        uint32_t tile;          // the other cluster's tile
+        uint16_t a, b;          // labels in this tile and in the other
+        bool operator==(const Pair& o) const { return tile == o.tile && a == o.a && b == o.b; }
+    };
+
+    static uint16_t root(uint16_t* uf, uint16_t a) {
+        while (uf[a] != a) a = uf[a] = uf[uf[a]];
+        return a;
+    }
+    // Labels only ever point to smaller ones, so resolving them in order sees each root first.
+    static uint16_t unite(uint16_t* uf, uint16_t a, uint16_t b) {
+        a = root(uf, a);
+        b = root(uf, b);
+        if (a > b) std::swap(a, b);
+        uf[b] = a;
+        return a;
+    }
+    uint32_t find(uint32_t a) {
+        while (parent_[a] != a) a = parent_[a] = parent_[parent_[a]];
+        return a;
+    }
+    // Keeps the smaller node as the root and splices the circular member lists.
+    void unite(uint32_t a, uint32_t b) {
+        a = find(a);
+        b = find(b);
+        if (a == b) return;
+        if (a > b) std::swap(a, b);
+        parent_[b] = a;
+        std::swap(next_[a], next_[b]);
+    }
+
+    void labelTile(const std::vector<uint8_t>& g, int tx, int ty) {
+        const int x0 = tx << kTileShift, y0 = ty << kTileShift;
+        const int tw = std::min(kTileSize, w_ - x0), th = std::min(kTileSize, h_ - y0);
+        uint16_t* uf = scratch_.data() + (size_t)ty * kScratch;
+        uint16_t* id = uf + kScratch / 2;
+        int n = 0;
+        for (int y = 0; y < th; ++y) {
+            const uint8_t* row = g.data() + (size_t)(y0 + y) * w_ + x0;
+            uint16_t* lab = label_.data() + (size_t)(y0 + y) * w_ + x0;
+            for (int x = 0; x < tw;) {
+                if (x + 8 <= tw && load64(row + x) == 0) {
+                    std::fill_n(lab + x, 8, 0);
+                    x += 8;
+                    continue;
+                }
+                if (!row[x]) {
+                    lab[x++] = 0;
+                    continue;
+                }
+                // Already labelled cells within two: the two rows above, and two to the left. A live
+                // cell one or two to the left has joined the columns up to one or two to the right.
+                uint16_t l = 0;
+                int dx0 = std::max(-2, -x);
+                const int dx1 = std::min(2, tw - 1 - x);
+                if (x >= 1 && lab[x - 1]) {
+                    l = root(uf, lab[x - 1]);
+                    dx0 = 2;
+                } else if (x >= 2 && lab[x - 2]) {
+                    l = root(uf, lab[x - 2]);
+                    dx0 = 1;
+                }
+                for (int dy = std::max(-2, -y); dy < 0; ++dy) {
+                    const uint16_t* near = lab + (ptrdiff_t)dy * w_ + x;
+                    for (int dx = dx0; dx <= dx1; ++dx) {
+                        const uint16_t m = near[dx];
+                        if (m && m != l) l = l ? unite(uf, l, m) : root(uf, m);
+                    }
+                }
+                if (!l) {
+                    l = (uint16_t)++n;
+                    uf[l] = l;
+                }
+                lab[x++] = l;
+            }
+        }
+
+        const size_t t = (size_t)ty * tiles_x_ + tx;
+        Cluster* cl = clusters_.data() + t * kMaxClusters;
+        int k = 0;
+        for (int l = 1; l <= n; ++l) {
+            uint16_t r = root(uf, (uint16_t)l);
+            id[l] = r == l ? (uint16_t)++k : id[r];
+        }
+        for (int c = 0; c < k; ++c) cl[c] = Cluster{0, 255, 255, 0, 0, -1};
+        for (int y = 0; y < th; ++y) {
+            const uint8_t* row = g.data() + (size_t)(y0 + y) * w_ + x0;
+            uint16_t* lab = label_.data() + (size_t)(y0 + y) * w_ + x0;
+            for (int x = 0; x < tw; ++x) {
+                if (x + 8 <= tw && load64(row + x) == 0) {
+                    x += 7;
+                    continue;
+                }
+                if (!row[x]) continue;
+                lab[x] = id[lab[x]];
+                Cluster& c = cl[lab[x] - 1];
+                ++c.cells;
+                c.x0 = std::min<uint8_t>(c.x0, (uint8_t)x), c.x1 = std::max<uint8_t>(c.x1, (uint8_t)x);
+                c.y0 = std::min<uint8_t>(c.y0, (uint8_t)y), c.y1 = std::max<uint8_t>(c.y1, (uint8_t)y);
+            }
+        }
+        cluster_count_[t] = (uint16_t)k;
+        if (!named) return;
+        const ObjectTable& table = ObjectTable::get();
+        for (int c = 0; c < k; ++c) {
+            Shape s;
+            if (addToShape(s, x0, y0, cl[c], (uint16_t)(c + 1), 0, 0)) cl[c].known = (int16_t)table.find(shapeHash(s));
+        }
+    }
+
+    // The cells labelled `label` within c's box of the tile at (x0, y0), at (ox, oy) in the shape.
+    // False if they do not fit.
+    bool addToShape(Shape& s, int x0, int y0, const Cluster& c, uint16_t label, int ox, int oy) const {
+        if (ox < 0 || oy < 0 || ox + c.x1 - c.x0 >= kShapeSpan || oy + c.y1 - c.y0 >= kShapeSpan) return false;
+        for (int y = c.y0; y <= c.y1; ++y) {
+            const uint16_t* lab = label_.data() + (size_t)(y0 + y) * w_ + x0;
+            for (int x = c.x0; x <= c.x1; ++x) {
+                if (lab[x] == label) s.rows[(size_t)(oy + y - c.y0)] |= (uint16_t)(1u << (ox + x - c.x0));
+            }
+        }
+        s.w = std::max(s.w, ox + c.x1 - c.x0 + 1);
+        s.h = std::max(s.h, oy + c.y1 - c.y0 + 1);
+        return true;
+    }
+
+    // Every pair of live cells at most two apart that lie in different tiles (or meet across the wrap),
+    // from this tile's side: fn(label here, other tile, label there). Each pair is seen once, from the
+    // cell that comes first in row order, so only offsets to the right and below are tried, and only
+    // from the two-cell bands along the tile's left, right and bottom edges.
+    template <typename F>
+    void forEachPair(const std::vector<uint8_t>& g, int tx, int ty, F&& fn) const {
+        const int x0 = tx << kTileShift, y0 = ty << kTileShift;
+        const int tw = std::min(kTileSize, w_ - x0), th = std::min(kTileSize, h_ - y0);
+        for (int y = 0; y < th; ++y) {
+            const bool bottom = y >= th - 2;
+            for (int x = 0; x < tw; ++x) {
+                if (!bottom && x == 2 && tw > 4) x = tw - 2;
+                const int gx = x0 + x, gy = y0 + y;
+                if (!g[(size_t)gy * w_ + gx]) continue;
+                const uint16_t a = label_[(size_t)gy * w_ + gx];
+                for (int dy = 0; dy <= 2; ++dy) {
+                    for (int dx = dy ? -2 : 1; dx <= 2; ++dx) {
+                        int nx = gx + dx, ny = gy + dy;
+                        const bool wrapped = nx < 0 || nx >= w_ || ny >= h_;
+                        if (wrapped) {
+                            if (!wrap_) continue;
+                            nx = mod(nx, w_), ny = mod(ny, h_);
+                        }
+                        const int ntx = nx >> kTileShift, nty = ny >> kTileShift;
+                        if (ntx == tx && nty == ty && !wrapped) continue;
+                        const size_t j = (size_t)ny * w_ + nx;
+                        if (g[j]) fn(a, (uint32_t)(nty * tiles_x_ + ntx), label_[j]);
+                    }
+                }
+            }
+        }
+    }
+
+    void listPairs(const std::vector<uint8_t>& g, int tx, int ty) {
+        const size_t t = (size_t)ty * tiles_x_ + tx;
+        Pair* out = pairs_.data() + t * kMaxPairs;
+        int n = 0;
+        bool overflow = false;
+        forEachPair(g, tx, ty, [&](uint16_t a, uint32_t other, uint16_t b) {
+            const Pair p{other, a, b};
+            for (int k = std::max(0, n - 4); k < n; ++k) {
+                if (out[k] == p) return; // neighbouring cells repeat their pairs
+            }
+            if (n < kMaxPairs) out[n++] = p;
+            else overflow = true;
+        });
+        pair_count_[t] = (uint16_t)n;
+        pair_overflow_[t] = overflow;
+    }
+
+    // Names a cluster joined across tiles from its members' cells, each placed at the copy across the
+    // wrap nearest the root's box (a cluster that fits the shape is nowhere near half the grid across).
+    int identifyJoined(uint32_t root, const ObjectTable& table) const {
+        struct Member {
+            int x0, y0;
+            const Cluster* c;
+            uint16_t label;
+        };
+        auto member = [&](uint32_t i) {
+            const size_t t = (size_t)(std::upper_bound(base_.begin(), base_.end(), i) - base_.begin()) - 1;
+            return Member{(int)(t % (size_t)tiles_x_) << kTileShift, (int)(t / (size_t)tiles_x_) << kTileShift,
+                          &clusters_[t * kMaxClusters + (i - base_[t])], (uint16_t)(i - base_[t] + 1)};
+        };
+        const Member r = member(root);
+        // Cell offset of member m's box from the root's box.
+        auto offset = [&](const Member& m, bool y) {
+            const int d = y ? m.y0 + m.c->y0 - r.y0 - r.c->y0 : m.x0 + m.c->x0 - r.x0 - r.c->x0, n = y ? h_ : w_;
+            return wrap_ ? mod(d + n / 2, n) - n / 2 : d;
+        };
+        constexpr int kFar = std::numeric_limits<int>::max();
+        int min_x = kFar, min_y = kFar, max_x = -kFar, max_y = -kFar;
+        uint32_t i = root;
+        do {
+            const Member m = member(i);
+            const int dx = offset(m, false), dy = offset(m, true);
+            min_x = std::min(min_x, dx), max_x = std::max(max_x, dx + m.c->x1 - m.c->x0);
+            min_y = std::min(min_y, dy), max_y = std::max(max_y, dy + m.c->y1 - m.c->y0);
+            if (max_x - min_x >= kShapeSpan || max_y - min_y >= kShapeSpan) return -1;
+            i = next_[i];
+        } while (i != root);
+        Shape s;
+        do {
+            const Member m = member(i);
+            if (!addToShape(s, m.x0, m.y0, *m.c, m.label, offset(m, false) - min_x, offset(m, true) - min_y)) return -1;
+            i = next_[i];
+        } while (i != root);
+        return table.find(shapeHash(s));
+    }
+
+    int w_ = 0, h_ = 0;
+    bool wrap_ = true;
+    int tiles_x_ = 0, tiles_y_ = 0;
+    int round_ = 0;
+    std::vector<uint16_t> label_;          // per cell: its cluster within the tile, 1-based; 0 = dead
+    std::vector<Cluster> clusters_;        // kMaxClusters per tile
+    std::vector<uint16_t> cluster_count_;
+    std::vector<Pair> pairs_;              // kMaxPairs per tile
+    std::vector<uint16_t> pair_count_;
+    std::vector<uint8_t> pair_overflow_;
+    std::vector<uint8_t> dirty_;           // main thread: changed since the last census
+    std::vector<uint8_t> stepped_;         // pool: changed by the step in flight
+    std::vector<uint8_t> relabel_, relist_;
+    std::vector<uint32_t> base_;           // first node of each tile's clusters
+    std::vector<uint32_t> parent_, next_;  // union-find over all clusters, and circular member lists
+    std::vector<uint16_t> scratch_;        // per tile row: provisional labels' parents, then cluster ids
+};
+
+// ---------------- Synthetic input (benchmark) ----------------
+
+// Deterministic stand-in for a user: paint/erase strokes and periodic window resizes, injected
+// through the normal event queue so they exercise exactly the code paths real input does.
+struct SyntheticInput {
+    std::mt19937 rng{12345};
+    int frame = 0;
+    int stroke_frames = 0;
+    int x = 0, y = 0;
+    uint8_t button = SDL_BUTTON_LEFT;
+    bool shrunk = false;
+    uint64_t paints = 0, resizes = 0;
+
+    static constexpr int kResizeEvery = 240;
+
+    static void push(const SDL_Event& e) {
+        SDL_Event copy = e;
+        SDL_PushEvent(&copy);
+    }
+
+    // base_w/base_h: the window's full size; resizes alternate between it and 3/4 of it.
+    void pump(SDL_Window* win, int base_w, int base_h) {
+        ++frame;
+
+        int win_w = 1, win_h = 1;
+        SDL_GetWindowSize(win, &win_w, &win_h);
+        auto rnd = [&](int n) { return (int)(rng() % (uint32_t)std::max(1, n)); };
+
+        SDL_Event e{};
+        if (stroke_frames == 0) {
+            x = rnd(win_w);
+            y = rnd(win_h);
+            button = (rnd(4) == 0) ? SDL_BUTTON_RIGHT : SDL_BUTTON_LEFT;
+            stroke_frames = 5 + rnd(36);
+            e.type = SDL_MOUSEBUTTONDOWN;
+            e.button.button = button;
+            e.button.x = x;
+            e.button.y = y;
+            push(e);
+        } else if (--stroke_frames == 0) {
+            e.type = SDL_MOUSEBUTTONUP;
+            e.button.button = button;
+            e.button.x = x;
+            e.button.y = y;
+            push(e);
+        } else {
+            x = std::clamp(x + rnd(33) - 16, 0, win_w - 1);
+            y = std::clamp(y + rnd(33) - 16, 0, win_h - 1);
+            e.type = SDL_MOUSEMOTION;
+            e.motion.x = x;
+            e.motion.y = y;
+            e.motion.state = (button == SDL_BUTTON_LEFT) ? SDL_BUTTON_LMASK : SDL_BUTTON_RMASK;
+            push(e);
+        }
+        ++paints;
+
+        if (frame % kResizeEvery == 0) {
+            shrunk = !shrunk;
+            SDL_SetWindowSize(win, shrunk ? base_w * 3 / 4 : base_w, shrunk ? base_h * 3 / 4 : base_h);
+            ++resizes;
+        }
+    }
+};
+
+// ---------------- Pattern export (RLE / plaintext) ----------------
+
+// Large block output buffer over a FILE*, with allocation-free integer formatting.
+class OutBuffer {
+public:
+    explicit OutBuffer(std::FILE* f, size_t cap = 4 << 20) : f_(f), buf_(cap) {}
+    ~OutBuffer() { flush(); }
+
+    void put(char c) {
+        if (n_ == buf_.size()) flush();
+        buf_[n_++] = c;
+    }
+    void put(const char* s, size_t k) {
+        for (;;) {
+            size_t room = std::min(k, buf_.size() - n_);
+            std::memcpy(buf_.data() + n_, s, room);
+            n_ += room;
+            s += room;
+            k -= room;
+            if (!k) return;
+            flush();
+        }
+    }
+    void put(const std::string& s) { put(s.data(), s.size()); }
+    void putRepeated(char c, size_t k) {
+        for (;;) {
+            size_t room = std::min(k, buf_.size() - n_);
+            std::memset(buf_.data() + n_, c, room);
+            n_ += room;
+            k -= room;
+            if (!k) return;
+            flush();
+        }
+    }
+    void putUint(uint64_t v) {
+        char tmp[20];
+        int k = 0;
+        do { tmp[k++] = (char)('0' + v % 10); v /= 10; } while (v);
+        if (buf_.size() - n_ < (size_t)k) flush();
+        while (k) buf_[n_++] = tmp[--k];
+    }
+    bool flush() {
+        if (n_ && std::fwrite(buf_.data(), 1, n_, f_) != n_) ok_ = false;
+        n_ = 0;
+        return ok_;
+    }
+    bool ok() const { return ok_; }
+
+private:
+    std::FILE* f_;
+    std::vector<char> buf_;
+    size_t n_ = 0;
+    bool ok_ = true;
+};
+
+static constexpr uint64_t kByteHighBits = 0x8080808080808080ull;
+
+// Calls fn(live, length) for each maximal run of equal liveness in row[x0, x1). Skips 8 cells per
+// step: a word's liveness mask is XORed against the current run's state and the first differing
+// byte found with count-trailing-zeros (little-endian byte order).
+template <class Fn>
+static void forEachRun(const uint8_t* row, int x0, int x1, Fn&& fn) {
+    int x = x0;
+    while (x < x1) {
+        bool live = row[x] != 0;
+        int e = x + 1;
+        for (;;) {
+            if (e + 8 <= x1) {
+                uint64_t m = nonZeroBytes(load64(row + e));
+                uint64_t diff = live ? (~m & kByteHighBits) : m;
+                if (diff) { e += lowestBit(diff) >> 3; break; }
+                e += 8;
+            } else {
+                while (e < x1 && (row[e] != 0) == live) ++e;
+                break;
+            }
+        }
+        fn(live, e - x);
+        x = e;
+    }
+}
+
+struct LiveBounds {
+    int x0 = 0, y0 = 0, x1 = 0, y1 = 0; // half-open; empty if x0 >= x1
+};
+
+// Bounding box of live cells, 8 cells per word.
+static LiveBounds liveBounds(const std::vector<uint8_t>& g, int w, int h) {
+    LiveBounds b{w, h, 0, 0};
+    for (int y = 0; y < h; ++y) {
+        const uint8_t* row = g.data() + (size_t)y * w;
+        int first = -1, last = -1;
+        int x = 0;
+        for (; x + 8 <= w; x += 8) {
+            uint64_t m = nonZeroBytes(load64(row + x));
+            if (!m) continue;
+            if (first < 0) first = x + (lowestBit(m) >> 3);
+            last = x + (highestBit(m) >> 3);
+        }
+        for (; x < w; ++x) {
+            if (!row[x]) continue;
+            if (first < 0) first = x;
+            last = x;
+        }
+        if (first < 0) continue;
+        b.x0 = std::min(b.x0, first);
+        b.x1 = std::max(b.x1, last + 1);
+        b.y0 = std::min(b.y0, y);
+        b.y1 = y + 1;
+    }
+    if (b.x0 >= b.x1) b = LiveBounds{};
+    return b;
+}
+
+// Extended RLE (as read by Golly and LifeViewer), trimmed to the live bounding box.
+static bool exportRle(const std::vector<uint8_t>& g, int w, int h, bool wrap, Neighborhood nb, Rule rule,
+                      uint64_t generation, const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    LiveBounds b = liveBounds(g, w, h);
+    if (nb == Neighborhood::Hex) b.y0 &= ~1; // keep row parity, which decides the hex offsets
+    {
+        OutBuffer out(f);
+        out.put("#C Conway screen saver, generation ");
+        out.putUint(generation);
+        // Golly's hex rules use a skewed square grid, not our offset rows; say which one this is.
+        if (nb == Neighborhood::Hex) out.put("\n#C hex, odd-r layout: odd rows are offset right by half a cell");
+        out.put("\nx = ");
+        out.putUint((uint64_t)(b.x1 - b.x0));
+        out.put(", y = ");
+        out.putUint((uint64_t)(b.y1 - b.y0));
+        out.put(", rule = ");
+        out.put(ruleString(rule, nb));
+        if (wrap) {
+            out.put(":T");
+            out.putUint((uint64_t)w);
+            out.put(",");
+            out.putUint((uint64_t)h);
+        }
+        out.put("\n");
+
+        int line = 0;
+        auto item = [&](uint64_t count, char tag) {
+            int len = 1;
+            for (uint64_t c = count; count > 1 && c; c /= 10) ++len;
+            if (line + len > 70) { out.put('\n'); line = 0; }
+            if (count > 1) out.putUint(count);
+            out.put(tag);
+            line += len;
+        };
+
+        uint64_t pending_rows = 0;
+        for (int y = b.y0; y < b.y1; ++y) {
+            const uint8_t* row = g.data() + (size_t)y * w;
+            uint64_t pending_dead = 0;
+            forEachRun(row, b.x0, b.x1, [&](bool live, int len) {
+                if (!live) { pending_dead = (uint64_t)len; return; }
+                if (pending_rows) { item(pending_rows, '$'); pending_rows = 0; }
+                if (pending_dead) { item(pending_dead, 'b'); pending_dead = 0; }
+                item((uint64_t)len, 'o');
+            });
+            ++pending_rows; // trailing dead cells and empty rows are implied
+        }
+        out.put("!\n");
+        if (!out.flush()) { std::fclose(f); return false; }
+    }
+    return std::fclose(f) == 0;
+}
+
+// Plaintext (.cells), trimmed to the live bounding box; trailing dead cells are omitted.
+static bool exportPlaintext(const std::vector<uint8_t>& g, int w, int h, uint64_t generation,
+                            const std::string& path) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    LiveBounds b = liveBounds(g, w, h);
+    {
+        OutBuffer out(f);
+        out.put("!Name: conway-gen");
+        out.putUint(generation);
+        out.put("\n");
+        for (int y = b.y0; y < b.y1; ++y) {
+            const uint8_t* row = g.data() + (size_t)y * w;
+            size_t pending_dead = 0;
+            forEachRun(row, b.x0, b.x1, [&](bool live, int len) {
+                if (!live) { pending_dead = (size_t)len; return; }
+                out.putRepeated('.', pending_dead);
+                pending_dead = 0;
+                out.putRepeated('O', (size_t)len);
+            });
+            out.put('\n');
+        }
+        if (!out.flush()) { std::fclose(f); return false; }
+    }
+    return std::fclose(f) == 0;
+}
+
+// 16-bit grayscale PGM (P5, big-endian samples), or with `raw` headerless little-endian uint16
+// samples, row by row.
+static bool exportActivity(const std::vector<uint16_t>& act, int w, int h, uint64_t from_gen, uint64_t to_gen,
+                           const std::string& path, bool raw) {
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    {
+        OutBuffer out(f);
+        if (!raw) {
+            out.put("P5\n# conway activity, generations ");
+            out.putUint(from_gen);
+            out.put("..");
+            out.putUint(to_gen);
+            out.put("\n");
+            out.putUint((uint64_t)w);
+            out.put(' ');
+            out.putUint((uint64_t)h);
+            out.put("\n65535\n");
+        }
+        for (size_t i = 0; i < (size_t)w * h; ++i) {
+            char b[2] = {(char)(act[i] >> 8), (char)(act[i] & 0xFF)};
+            if (raw) std::swap(b[0], b[1]);
+            out.put(b, 2);
+        }
+        if (!out.flush()) { std::fclose(f); return false; }
+    }
+    return std::fclose(f) == 0;
+}
+
+static bool endsWith(const std::string& s, const std::string& suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// ---------------- Run-length engine ----------------
+
+// Live cells of each row as sorted, disjoint half-open runs [start, end), all rows in one flat
+// array (CSR layout): row y's runs are the pairs in runs[row_at[y] .. row_at[y + 1]).
+struct RunGrid {
+    std::vector<int32_t> runs;
+    std::vector<uint32_t> row_at;
+
+    void begin() {
+        runs.clear();
+        row_at.clear();
+        row_at.push_back(0);
+    }
+    void endRow() { row_at.push_back((uint32_t)runs.size()); }
+    int rows() const { return (int)row_at.size() - 1; }
+    const int32_t* row(int y) const { return runs.data() + row_at[y]; }
+    int count(int y) const { return (int)(row_at[y + 1] - row_at[y]) / 2; }
+};
+
+static void appendRowRuns(const uint8_t* row, int w, std::vector<int32_t>& out) {
+    int x = 0;
+    forEachRun(row, 0, w, [&](bool live, int len) {
+        if (live) {
+            out.push_back(x);
+            out.push_back(x + len);
+        }
+        x += len;
+    });
+}
+
+// Steps a RunGrid and mirrors the result into the dense age grid used for rendering. Work per
+// generation is O(rows + runs): empty rows with empty neighbours are skipped, and the dense sync
+// only touches cells that are or were alive. Painting and resizes mark rows for re-encoding.
+class RunEngine {
+public:
+    void reserve(int max_w, int max_h) {
+        row_dirty_.reserve((size_t)max_h);
+        for (auto& e : ext_) e.reserve((size_t)max_w + 8);
+        cand_.reserve((size_t)max_w * 9 + 8);
+    }
+
+    // Re-encode every row from the dense grid (startup, resize, restore).
+    void markAll(int w, int h) {
+        w_ = w;
+        h_ = h;
+        row_dirty_.assign((size_t)h, 1);
+        all_dirty_ = true;
+    }
+    void markRow(int y) {
+        if (y >= 0 && y < h_) {
+            row_dirty_[(size_t)y] = 1;
+            any_dirty_ = true;
+        }
+    }
+
+    size_t runCount() const { return cur_.runs.size() / 2; }
+    size_t bytes() const {
+        size_t ints = cur_.runs.capacity() + spare_.runs.capacity() + cand_.capacity();
+        for (const auto& e : ext_) ints += e.capacity();
+        return ints * sizeof(int32_t) + (cur_.row_at.capacity() + spare_.row_at.capacity()) * sizeof(uint32_t) +
+               row_dirty_.capacity();
+    }
+
+    // With `cost` (one slot per tile), each tile row's time is spread evenly over its tiles and added
+    // to their slots: rows are merged whole, so the cost is only resolved vertically. With
+    // `activity`, flips are counted from the old and new runs of each row.
+    uint64_t step(std::vector<uint8_t>& dense, int w, int h, bool wrap, int max_age, Neighborhood nb, Rule rule,
+                  TileGrid& tiles, uint64_t* cost = nullptr, uint16_t* activity = nullptr) {
+        if (w != w_ || h != h_ || cur_.rows() != h) markAll(w, h);
+        syncFromDense(dense);
+
+        uint8_t cap = (uint8_t)std::clamp(max_age, 1, 255);
+        uint64_t population = 0;
+        RunGrid& out = spare_;
+        out.begin();
+
+        auto band_start = cost ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+        for (int y = 0; y < h; ++y) {
+            int ya = y - 1, yb = y + 1;
+            if (wrap) {
+                ya = mod(ya, h);
+                yb = mod(yb, h);
+            }
+            bool has_a = ya >= 0 && ya < h, has_b = yb >= 0 && yb < h;
+            bool empty = cur_.count(y) == 0 && (!has_a || cur_.count(ya) == 0) && (!has_b || cur_.count(yb) == 0);
+            size_t row_begin = out.runs.size();
+            if (!empty) {
+                loadRow(0, has_a ? ya : -1, w, wrap);
+                loadRow(1, y, w, wrap);
+                loadRow(2, has_b ? yb : -1, w, wrap);
+                stepRow(w, rowWindow(nb, (y & 1) != 0), rule, out.runs);
+            }
+            out.endRow();
+
+            const int32_t* nr = out.runs.data() + row_begin;
+            int nn = (int)(out.runs.size() - row_begin) / 2;
+            for (int i = 0; i < nn; ++i) population += (uint64_t)(nr[2 * i + 1] - nr[2 * i]);
+            if (activity) accumulateActivityRuns(activity + (size_t)y * w, cur_.row(y), cur_.count(y), nr, nn);
+            syncRow(dense.data() + (size_t)y * w, cur_.row(y), cur_.count(y), nr, nn, cap, y, tiles);
+            if (cost && ((y + 1) % kTileSize == 0 || y + 1 == h)) {
+                auto t = std::chrono::steady_clock::now();
+                uint64_t per_tile = elapsedNs(band_start, t) / (uint64_t)tiles.tiles_x;
+                uint64_t* row_cost = cost + (size_t)(y >> kTileShift) * tiles.tiles_x;
+                for (int tx = 0; tx < tiles.tiles_x; ++tx) row_cost[tx] += per_tile;
+                band_start = t;
+            }
+        }
+        std::swap(cur_, spare_);
+        return population;
+    }
+
+    // `gens` generations in one call. The runs stay internal between generations; the dense grid is
+    // still synced every generation because it holds the ages.
+    uint64_t advance(std::vector<uint8_t>& dense, int w, int h, int gens, bool wrap, int max_age, Neighborhood nb,
+                     Rule rule, TileGrid& tiles, uint64_t* cost = nullptr, uint16_t* activity = nullptr) {
+        uint64_t population = 0;
+        for (int g = 0; g < std::max(1, gens); ++g) {
+            population = step(dense, w, h, wrap, max_age, nb, rule, tiles, cost, activity);
+        }
+        return population;
+    }
+
+private:
+    void syncFromDense(const std::vector<uint8_t>& dense) {
+        if (!all_dirty_ && !any_dirty_) return;
+        // Copy clean rows' runs, re-encode dirty rows, then swap.
+        spare_.begin();
+        for (int y = 0; y < h_; ++y) {
+            if (all_dirty_ || row_dirty_[(size_t)y]) {
+                appendRowRuns(dense.data() + (size_t)y * w_, w_, spare_.runs);
+            } else {
+                spare_.runs.insert(spare_.runs.end(), cur_.row(y), cur_.row(y) + 2 * cur_.count(y));
+            }
+            spare_.endRow();
+        }
+        std::swap(cur_, spare_);
+        std::fill(row_dirty_.begin(), row_dirty_.end(), 0);
+        all_dirty_ = any_dirty_ = false;
+    }
+
+    // ext_[k] = row y's runs; when wrapping, plus the runs that touch the far edge shifted by -w/+w
+    // so the window at x = 0 and x = w - 1 sees its neighbours across the seam.
+    void loadRow(int k, int y, int w, bool wrap) {
+        std::vector<int32_t>& e = ext_[k];
+        e.clear();
+        if (y < 0) return;
+        const int32_t* r = cur_.row(y);
+        int n = cur_.count(y);
+        if (n == 0) return;
+        if (wrap && r[2 * n - 1] == w) { e.push_back(r[2 * n - 2] - w); e.push_back(0); }
+        e.insert(e.end(), r, r + 2 * n);
+        if (wrap && r[0] == 0) { e.push_back(w); e.push_back(r[1] + w); }
+    }
+
+    // Cells of rows y-1, y, y+1 that neighbour x lie in [x + lo[k], x + hi[k]] (the centre row's
+    // window includes x itself, which is subtracted again).
+    struct RowWindow {
+        int lo[3], hi[3];
+    };
+    static RowWindow rowWindow(Neighborhood nb, bool odd_row) {
+        switch (nb) {
+            case Neighborhood::VonNeumann: return {{0, -1, 0}, {0, 1, 0}};
+            case Neighborhood::Hex:
+                return odd_row ? RowWindow{{0, -1, 0}, {1, 1, 1}} : RowWindow{{-1, -1, -1}, {0, 1, 0}};
+            default: return {{-1, -1, -1}, {1, 1, 1}};
+        }
+    }
+
+    // Neighbour counts are piecewise constant between the points b-hi..b-lo around every run
+    // boundary b of the three rows, so the rule is evaluated once per segment.
+    void stepRow(int w, const RowWindow& win, Rule rule, std::vector<int32_t>& out) {
+        cand_.clear();
+        cand_.push_back(0);
+        for (int k = 0; k < 3; ++k) {
+            const std::vector<int32_t>& e = ext_[k];
+            for (size_t i = 0; i < e.size(); i += 2) {
+                for (int d = -win.hi[k]; d <= -win.lo[k]; ++d) {
+                    int32_t a = e[i] + d, b = e[i + 1] + d;
+                    if (a > 0 && a < w) cand_.push_back(a);
+                    if (b > 0 && b < w) cand_.push_back(b);
+                }
+            }
+        }
+        std::sort(cand_.begin(), cand_.end());
+        cand_.erase(std::unique(cand_.begin(), cand_.end()), cand_.end());
+
+        size_t p[3] = {0, 0, 0};
+        size_t out_row = out.size();
+        for (size_t c = 0; c < cand_.size(); ++c) {
+            int32_t x = cand_[c];
+            int32_t x_end = (c + 1 < cand_.size()) ? cand_[c + 1] : w;
+            int n = 0;
+            bool alive = false;
+            for (int k = 0; k < 3; ++k) {
+                const std::vector<int32_t>& e = ext_[k];
+                int32_t lo = x + win.lo[k], hi = x + win.hi[k] + 1;
+                while (p[k] < e.size() && e[p[k] + 1] <= lo) p[k] += 2;
+                for (size_t q = p[k]; q < e.size() && e[q] < hi; q += 2) {
+                    n += std::min(e[q + 1], hi) - std::max(e[q], lo);
+                    if (k == 1 && e[q] <= x && x < e[q + 1]) alive = true;
+                }
+            }
+            if (alive) --n;
+            bool next = ((alive ? rule.survive : rule.birth) >> n) & 1;
+            if (!next) continue;
+            if (out.size() > out_row && out.back() == x) out.back() = x_end;
+            else { out.push_back(x); out.push_back(x_end); }
+        }
+    }
+
+    // Apply one row's liveness change to the dense ages: cells in new runs age (or are born),
+    // cells only in old runs die. Flags tiles the row's runs touch when the row changed.
+    static void syncRow(uint8_t* row, const int32_t* old_r, int old_n, const int32_t* new_r, int new_n,
+                        uint8_t cap, int y, TileGrid& tiles) {
+        bool same = old_n == new_n && std::equal(old_r, old_r + 2 * old_n, new_r);
+        for (int i = 0; i < new_n; ++i) {
+            for (int32_t x = new_r[2 * i]; x < new_r[2 * i + 1]; ++x) {
+                uint8_t a = row[x];
+                row[x] = a ? ((a < cap) ? (uint8_t)(a + 1) : cap) : 1;
+            }
+        }
+        if (same) return;
+        int j = 0;
+        for (int i = 0; i < old_n; ++i) {
+            int32_t s = old_r[2 * i], e = old_r[2 * i + 1];
+            while (j < new_n && new_r[2 * j + 1] <= s) ++j;
+            for (int32_t x = s; x < e;) {
+                // Skip the part covered by new runs.
+                int k = j;
+                while (k < new_n && new_r[2 * k + 1] <= x) ++k;
+                if (k < new_n && new_r[2 * k] <= x) { x = new_r[2 * k + 1]; continue; }
+                int32_t stop = (k < new_n) ? std::min(e, new_r[2 * k]) : e;
+                std::memset(row + x, 0, (size_t)(stop - x));
+                x = stop;
+            }
+        }
+        uint8_t* changed = &tiles.changed[(size_t)(y >> kTileShift) * tiles.tiles_x];
+        for (int i = 0; i < old_n; ++i) {
+            for (int t = old_r[2 * i] >> kTileShift; t <= (old_r[2 * i + 1] - 1) >> kTileShift; ++t) changed[t] = 1;
+        }
+        for (int i = 0; i < new_n; ++i) {
+            for (int t = new_r[2 * i] >> kTileShift; t <= (new_r[2 * i + 1] - 1) >> kTileShift; ++t) changed[t] = 1;
+        }
+    }
+
+    int w_ = 0, h_ = 0;
+    RunGrid cur_, spare_;
+    std::vector<uint8_t> row_dirty_;
+    bool all_dirty_ = true, any_dirty_ = false;
+    std::vector<int32_t> ext_[3];
+    std::vector<int32_t> cand_;
+};
+
+// ---------------- Continuous engine (Lenia) ----------------
+//
+// --engine=lenia: a float state in [0, 1] per cell, on the torus. Each generation computes
+// A' = clip(A + dt * G(K * A)), where K is a smooth ring kernel of radius R (--lenia-radius) and
+// G(u) = 2 exp(-(u - mu)^2 / 2 sigma^2) - 1 is the growth function. At screen resolution R is far
+// too wide for a direct sum, so the convolution goes through 2D FFTs:
+//   round 0  rows, two real rows per complex FFT, split into their half spectra (w/2+1 columns)
+//   round 1  columns, in groups of kColumnGroup: forward FFT, product with the kernel's spectrum,
+//            inverse FFT
+//   round 2  rows again (two real rows per inverse FFT), then the growth step
+// Each round is split into kChunks pool chunks. The grid is trimmed to even 2-3-5-smooth sizes, which
+// the mixed-radix FFT handles. `cur` carries the state quantised to 0..255 for drawing, hashing,
+// exports and checkpoints.
+
+struct Cf {
+    float re, im;
+};
+static_assert(sizeof(Cf) == 2 * sizeof(float), "Cf arrays are read as interleaved floats");
+static inline Cf operator+(Cf a, Cf b) { return Cf{a.re + b.re, a.im + b.im}; }
+static inline Cf operator-(Cf a, Cf b) { return Cf{a.re - b.re, a.im - b.im}; }
+static inline Cf operator*(Cf a, Cf b) { return Cf{a.re * b.re - a.im * b.im, a.re * b.im + a.im * b.re}; }
+static inline Cf operator*(Cf a, float s) { return Cf{a.re * s, a.im * s}; }
+static inline Cf conj(Cf a) { return Cf{a.re, -a.im}; }
+static inline Cf mulI(Cf a) { return Cf{-a.im, a.re}; } // a * i
+
+// Mixed-radix (4, 2, 3, 5) Stockham FFT of one length, over a batch of B interleaved sequences
+// (element t of sequence c at x[t * B + c], so B adjacent columns of a row-major grid transform in
+// place of one). run() ping-pongs between its two buffers and returns the one holding the result; the
+// inverse is unscaled.
+class FftPlan {
+public:
+    static constexpr double kPi = 3.14159265358979323846;
+
+    void reserve(int max_n) { tw_.reserve((size_t)max_n); }
+
+    // False if n has a prime factor above 5.
+    bool init(int n) {
+        n_ = n;
+        stages_ = 0;
+        tw_.clear();
+        int r = n;
+        while (r > 1 && stages_ < kMaxStages) {
+            int p = r % 4 == 0 ? 4 : r % 2 == 0 ? 2 : r % 3 == 0 ? 3 : r % 5 == 0 ? 5 : 0;
+            if (!p) return false;
+            radix_[stages_++] = p;
+            r /= p;
+        }
+        int len = n;
+        for (int s = 0; s < stages_; ++s) {
+            int p = radix_[s], m = len / p;
+            for (int j = 0; j < m; ++j) {
+                for (int t = 1; t < p; ++t) {
+                    double a = -2.0 * kPi * (double)j * t / len;
+                    tw_.push_back(Cf{(float)std::cos(a), (float)std::sin(a)});
+                }
+            }
+            len = m;
+        }
+        return r == 1;
+    }
+
+    int size() const { return n_; }
+
+    template <bool Inverse, int B = 1>
+    Cf* run(Cf* x, Cf* y) const {
+        const Cf* tw = tw_.data();
+        int len = n_, s = 1;
+        for (int st = 0; st < stages_; ++st) {
+            const int p = radix_[st], m = len / p;
+            switch (p) {
+                case 2: stage<2, Inverse, B>(x, y, m, s, tw); break;
+                case 3: stage<3, Inverse, B>(x, y, m, s, tw); break;
+                case 4: stage<4, Inverse, B>(x, y, m, s, tw); break;
+                default: stage<5, Inverse, B>(x, y, m, s, tw); break;
+            }
+            tw += (size_t)m * (p - 1);
+            std::swap(x, y);
+            len = m;
+            s *= p;
+        }
+        return x;
+    }
+
+private:
+    static constexpr int kMaxStages = 32;
+
+    // f(0), ..., f(N - 1) spelled out, so the butterfly operands stay in registers.
+    template <typename F, int... I>
+    static void unrolled(F&& f, std::integer_sequence<int, I...>) { (f(I), ...); }
+
+    template <int P, bool Inverse, int B>
+    static void stage(const Cf* x, Cf* y, int m, int s, const Cf* tw) {
+        constexpr auto radix = std::make_integer_sequence<int, P>{};
+        const size_t in_step = (size_t)s * m * B, out_step = (size_t)s * B;
+        for (int j = 0; j < m; ++j, tw += P - 1) {
+            Cf w[P];
+            unrolled([&](int t) { w[t] = t == 0 ? Cf{1.0f, 0.0f} : Inverse ? conj(tw[t - 1]) : tw[t - 1]; }, radix);
+            for (int q = 0; q < s; ++q) {
+                const Cf* in = x + (size_t)(q + s * j) * B;
+                Cf* out = y + (size_t)(q + s * P * j) * B;
+                for (int c = 0; c < B; ++c) {
+                    Cf a[P], b[P];
+                    unrolled([&](int r) { a[r] = in[in_step * r + c]; }, radix);
+                    butterfly<P, Inverse>(a, b);
+                    unrolled([&](int t) { out[out_step * t + c] = t == 0 ? b[0] : b[t] * w[t]; }, radix);
+                }
+            }
+        }
+    }
+
+    template <int P, bool Inverse>
+    static void butterfly(const Cf* a, Cf* b) {
+        constexpr float sg = Inverse ? 1.0f : -1.0f; // sign of the exponent
+        if constexpr (P == 2) {
+            b[0] = a[0] + a[1];
+            b[1] = a[0] - a[1];
+        } else if constexpr (P == 4) {
+            Cf t0 = a[0] + a[2], t1 = a[0] - a[2], t2 = a[1] + a[3], t3 = mulI(a[1] - a[3]) * sg;
+            b[0] = t0 + t2;
+            b[1] = t1 + t3;
+            b[2] = t0 - t2;
+            b[3] = t1 - t3;
+        } else if constexpr (P == 3) {
+            constexpr float s3 = 0.86602540378f * sg;
+            Cf t = a[1] + a[2], m1 = a[0] - t * 0.5f, m2 = mulI(a[1] - a[2]) * s3;
+            b[0] = a[0] + t;
+            b[1] = m1 + m2;
+            b[2] = m1 - m2;
+        } else {
+            constexpr float c1 = 0.30901699437f, c2 = -0.80901699437f;
+            constexpr float s1 = 0.95105651630f * sg, s2 = 0.58778525229f * sg;
+            Cf t1 = a[1] + a[4], t2 = a[2] + a[3], t3 = a[1] - a[4], t4 = a[2] - a[3];
+            Cf b1 = a[0] + t1 * c1 + t2 * c2, b2 = a[0] + t1 * c2 + t2 * c1;
+            Cf d1 = mulI(t3 * s1 + t4 * s2), d2 = mulI(t3 * s2 - t4 * s1);
+            b[0] = a[0] + t1 + t2;
+            b[1] = b1 + d1;
+            b[4] = b1 - d1;
+            b[2] = b2 + d2;
+            b[3] = b2 - d2;
+        }
+    }
+
+    int n_ = 0;
+    int stages_ = 0;
+    int radix_[kMaxStages] = {};
+    std::vector<Cf> tw_;
+};
+
+// --verify: largest state difference per step the FFT engine (single precision, tabulated growth) may
+// show against the direct double-precision convolution.
+static constexpr double kLeniaTolerance = 1e-3;
+
+class LeniaEngine {
+public:
+    static constexpr int kChunks = 32;
+    static constexpr int kRounds = 3;       // pool rounds per generation
+    static constexpr int kColumnGroup = 8;  // columns gathered per pass, one cache line of rows
+    static constexpr int kGrowthLut = 4096;
+
+    // Buffers for grids up to max_w x max_h (after fftSize), so resizes do not allocate.
+    void reserve(int max_w, int max_h, const Config& c) {
+        size_t cells = (size_t)max_w * max_h, half = (size_t)(max_w / 2 + 1) * max_h;
+        field_.reserve(cells);
+        spec_.reserve(half);
+        khat_.reserve(half);
+        size_t per_chunk = std::max(2 * (size_t)max_w, 2 * (size_t)kColumnGroup * max_h);
+        scratch_.reserve(per_chunk * kChunks);
+        row_plan_.reserve(max_w);
+        col_plan_.reserve(max_h);
+        int r = std::clamp(c.lenia_radius, 1, kMaxRadius);
+        taps_.reserve((size_t)(2 * r + 1) * (2 * r + 1));
+        growth_lut_.reserve(kGrowthLut + 2);
+        if (c.verify) {
+            ref_in_.reserve(cells);
+            ref_out_.reserve(cells);
+        }
+    }
+
+    // (Re)builds the FFT plans, the kernel spectrum and the growth table for a w x h torus. Nothing
+    // happens when neither the size nor the parameters changed. Main thread, no step in flight.
+    void configure(int w, int h, const Config& c) {
+        int radius = std::clamp(c.lenia_radius, 1, std::max(1, std::min({w, h, 2 * kMaxRadius}) / 2 - 1));
+        if (w == w_ && h == h_ && radius == radius_ && c.lenia_mu == mu_ && c.lenia_sigma == sigma_) return;
+        w_ = w;
+        h_ = h;
+        hw_ = w / 2 + 1;
+        radius_ = radius;
+        mu_ = c.lenia_mu;
+        sigma_ = c.lenia_sigma;
+        row_plan_.init(w);
+        col_plan_.init(h);
+        spec_.resize((size_t)hw_ * h);
+        khat_.resize((size_t)hw_ * h);
+        field_.resize((size_t)w * h);
+        scratch_stride_ = std::max(2 * (size_t)w, 2 * (size_t)kColumnGroup * h);
+        scratch_.resize(scratch_stride_ * kChunks);
+
+        // Ring kernel: the exponential bump exp(4 - 1 / (r (1 - r))) of the distance r in radii,
+        // peaking at half the radius; normalised to sum 1.
+        taps_.clear();
+        double sum = 0.0;
+        for (int dy = -radius; dy <= radius; ++dy) {
+            for (int dx = -radius; dx <= radius; ++dx) {
+                double r = std::sqrt((double)(dx * dx + dy * dy)) / radius;
+                if (r <= 0.0 || r >= 1.0) continue;
+                double v = std::exp(4.0 - 1.0 / (r * (1.0 - r)));
+                taps_.push_back(Tap{dx, dy, (float)v});
+                sum += v;
+            }
+        }
+        for (auto& t : taps_) t.weight = (float)(t.weight / sum);
+
+        // Its spectrum, through the same row and column passes; it is real (the kernel is even), and
+        // the inverse transform's 1/(w h) is folded in.
+        std::vector<float>& img = field_; // reloaded from `cur` by the caller
+        std::fill(img.begin(), img.end(), 0.0f);
+        for (const Tap& t : taps_) img[(size_t)mod(t.dy, h) * w + (size_t)mod(t.dx, w)] += t.weight;
+        for (int k = 0; k < kChunks; ++k) forwardRows(k);
+        const float scale = 1.0f / ((float)w * (float)h);
+        Cf* col = scratch_.data();
+        Cf* work = col + h;
+        for (int kx = 0; kx < hw_; ++kx) {
+            for (int y = 0; y < h; ++y) col[y] = spec_[(size_t)y * hw_ + kx];
+            const Cf* f = col_plan_.run<false>(col, work);
+            for (int y = 0; y < h; ++y) khat_[(size_t)y * hw_ + kx] = f[y].re * scale;
+        }
+
+        growth_lut_.resize(kGrowthLut + 2);
+        for (int i = 0; i <= kGrowthLut + 1; ++i) growth_lut_[(size_t)i] = (float)growth((double)i / kGrowthLut);
+    }
+
+    // State from quantised cells (after seeding, restores, resizes).
+    void load(const std::vector<uint8_t>& cur) {
+        for (size_t i = 0; i < field_.size(); ++i) field_[i] = cur[i] * (1.0f / 255.0f);
+    }
+    void set(size_t i, uint8_t q) { field_[i] = q * (1.0f / 255.0f); }
+
+    // Main thread, before a step: snapshot for --verify.
+    void beginVerify() { ref_in_.assign(field_.begin(), field_.end()); }
+
+    // Main thread, after a step of `gens` generations: largest state difference between the engine
+    // and a direct (non-FFT) convolution in double precision with the exact growth function.
+    double verify(int gens, double dt) {
+        ref_out_.resize(ref_in_.size());
+        for (int g = 0; g < gens; ++g) {
+            for (int y = 0; y < h_; ++y) {
+                for (int x = 0; x < w_; ++x) {
+                    double u = 0.0;
+                    for (const Tap& t : taps_) u += (double)t.weight * ref_in_[(size_t)mod(y + t.dy, h_) * w_ + mod(x + t.dx, w_)];
+                    double a = ref_in_[(size_t)y * w_ + x] + dt * growth(u);
+                    ref_out_[(size_t)y * w_ + x] = (float)std::clamp(a, 0.0, 1.0);
+                }
+            }
+            ref_in_.swap(ref_out_);
+        }
+        double err = 0.0;
+        for (size_t i = 0; i < field_.size(); ++i) err = std::max(err, (double)std::fabs(field_[i] - ref_in_[i]));
+        return err;
+    }
+
+    // One chunk of a round (0..kRounds-1). The last round writes the quantised state to `out`
+    // (`cur` keeps the previous one) and returns the chunk's population; `activity` counts liveness
+    // changes.
+    uint64_t run(int round, int chunk, float dt, std::vector<uint8_t>& out, uint16_t* activity) {
+        switch (round) {
+            case 0: forwardRows(chunk); return 0;
+            case 1: columns(chunk); return 0;
+            default: return inverseRows(chunk, dt, out, activity);
+        }
+    }
+
+    size_t bytes() const {
+        return field_.capacity() * sizeof(float) + (spec_.capacity() + scratch_.capacity()) * sizeof(Cf) +
+               khat_.capacity() * sizeof(float) + (ref_in_.capacity() + ref_out_.capacity()) * sizeof(float);
+    }
+    static uint64_t estimateBytes(uint64_t w, uint64_t h, bool verify) {
+        uint64_t half = (w / 2 + 1) * h;
+        return w * h * sizeof(float) * (verify ? 3 : 1) + half * (sizeof(Cf) + sizeof(float)) +
+               std::max(2 * w, 2 * (uint64_t)kColumnGroup * h) * kChunks * sizeof(Cf);
+    }
+
+private:
+    static constexpr int kMaxRadius = 256;
+    static constexpr float kLive = 0.5f / 255.0f; // smallest state that quantises to a non-zero level
+
+    struct Tap {
+        int dx, dy;
+        float weight;
+    };
+
+    double growth(double u) const {
+        double d = (u - mu_) / sigma_;
+        return 2.0 * std::exp(-0.5 * d * d) - 1.0;
+    }
+
+    void range(int chunk, int n, int& b, int& e) const {
+        b = (int)((int64_t)n * chunk / kChunks);
+        e = (int)((int64_t)n * (chunk + 1) / kChunks);
+    }
+    Cf* scratch(int chunk) { return scratch_.data() + scratch_stride_ * (size_t)chunk; }
+
+    // Rows 2p and 2p+1 as the real and imaginary parts of one FFT; Z[k] and conj(Z[w-k]) separate
+    // into the two rows' spectra.
+    void forwardRows(int chunk) {
+        int b = 0, e = 0;
+        range(chunk, h_ / 2, b, e);
+        Cf* z = scratch(chunk);
+        Cf* work = z + w_;
+        for (int p = b; p < e; ++p) {
+            const float* ra = field_.data() + (size_t)(2 * p) * w_;
+            const float* rb = ra + w_;
+            for (int x = 0; x < w_; ++x) z[x] = Cf{ra[x], rb[x]};
+            const Cf* f = row_plan_.run<false>(z, work);
+            Cf* sa = spec_.data() + (size_t)(2 * p) * hw_;
+            Cf* sb = sa + hw_;
+            for (int k = 0; k < hw_; ++k) {
+                Cf zk = f[k], zn = conj(f[k ? w_ - k : 0]);
+                sa[k] = (zk + zn) * 0.5f;
+                sb[k] = mulI(zn - zk) * 0.5f; // (zk - zn) / 2i
+            }
+        }
+    }
+
+    // kColumnGroup adjacent columns at a time, copied out row by row and transformed as one batch;
+    // the last group is padded with zero columns.
+    void columns(int chunk) {
+        int b = 0, e = 0;
+        const int groups = (hw_ + kColumnGroup - 1) / kColumnGroup;
+        range(chunk, groups, b, e);
+        Cf* cols = scratch(chunk);
+        Cf* work = cols + (size_t)kColumnGroup * h_;
+        for (int g = b; g < e; ++g) {
+            const int k0 = g * kColumnGroup, n = std::min(kColumnGroup, hw_ - k0);
+            for (int y = 0; y < h_; ++y) {
+                Cf* c = cols + (size_t)y * kColumnGroup;
+                std::copy_n(spec_.data() + (size_t)y * hw_ + k0, n, c);
+                std::fill(c + n, c + kColumnGroup, Cf{});
+            }
+            Cf* f = col_plan_.run<false, kColumnGroup>(cols, work);
+            for (int y = 0; y < h_; ++y) {
+                const float* k = khat_.data() + (size_t)y * hw_ + k0;
+                Cf* c = f + (size_t)y * kColumnGroup;
+                for (int i = 0; i < n; ++i) c[i] = c[i] * k[i];
+            }
+            const Cf* r = col_plan_.run<true, kColumnGroup>(f, f == cols ? work : cols);
+            for (int y = 0; y < h_; ++y) std::copy_n(r + (size_t)y * kColumnGroup, n, spec_.data() + (size_t)y * hw_ + k0);
+        }
+    }
+
+    // The two rows' (Hermitian) spectra rebuilt to full length as Ya + i Yb, so one inverse FFT yields
+    // both convolved rows; then the growth step.
+    uint64_t inverseRows(int chunk, float dt, std::vector<uint8_t>& out, uint16_t* activity) {
+        int b = 0, e = 0;
+        range(chunk, h_ / 2, b, e);
+        Cf* z = scratch(chunk);
+        Cf* work = z + w_;
+        uint64_t population = 0;
+        const float lut_scale = (float)kGrowthLut;
+        const float* lut = growth_lut_.data(); // locals: the uint8_t stores may alias anything
+        for (int p = b; p < e; ++p) {
+            const Cf* sa = spec_.data() + (size_t)(2 * p) * hw_;
+            const Cf* sb = sa + hw_;
+            for (int k = 0; k < hw_; ++k) z[k] = sa[k] + mulI(sb[k]);
+            for (int k = hw_; k < w_; ++k) z[k] = conj(sa[w_ - k]) + mulI(conj(sb[w_ - k]));
+            const Cf* u = row_plan_.run<true>(z, work);
+            for (int half = 0; half < 2; ++half) {
+                const size_t row = (size_t)(2 * p + half) * w_;
+                float* a = field_.data() + row;
+                uint8_t* q = out.data() + row;
+                uint16_t* act = activity ? activity + row : nullptr;
+                const float* conv = reinterpret_cast<const float*>(u) + half; // the row's re or im, stride 2
+                const int n = w_;
+                uint32_t live = 0;
+                for (int x = 0; x < n; ++x) {
+                    float v = std::clamp(conv[2 * x] * lut_scale, 0.0f, lut_scale);
+                    int i = (int)v;
+                    float g = lut[i] + (lut[i + 1] - lut[i]) * (v - (float)i);
+                    float before = a[x];
+                    float after = std::clamp(before + dt * g, 0.0f, 1.0f);
+                    a[x] = after;
+                    uint8_t level = (uint8_t)(after * 255.0f + 0.5f);
+                    q[x] = level;
+                    live += level != 0;
+                    // Quantised liveness changed: below 1/510 rounds to 0.
+                    if (act && (before >= kLive) != (after >= kLive) && act[x] != UINT16_MAX) ++act[x];
+                }
+                population += live;
+            }
+        }
+        return population;
+    }
+
+    int w_ = 0, h_ = 0, hw_ = 0;
+    int radius_ = 0;
+    double mu_ = 0.0, sigma_ = 1.0;
+    FftPlan row_plan_, col_plan_;
+    std::vector<float> field_;
+    std::vector<Cf> spec_;       // h rows of hw_ columns: the half spectrum, in place through the rounds
+    std::vector<float> khat_;    // kernel spectrum, scaled by 1 / (w h)
+    std::vector<Cf> scratch_;    // per chunk: a row and its work buffer, or a column group and its work buffer
+    size_t scratch_stride_ = 0;
+    std::vector<Tap> taps_;
+    std::vector<float> growth_lut_;
+    std::vector<float> ref_in_, ref_out_;
+};
+
+// The rule for reports: Golly notation, or the Lenia kernel and growth parameters.
+static std::string ruleLabel(const Config& c) {
+    if (c.engine != Engine::Lenia) return ruleString(c.rule, c.neighborhood);
+    std::ostringstream os;
+    os << "R=" << c.lenia_radius << " mu=" << c.lenia_mu << " sigma=" << c.lenia_sigma << " dt=" << c.lenia_dt;
+    return os.str();
+}
+
+// ---------------- Input record/replay ----------------
+//
+// Log layout (all integers LEB128 varints unless noted):
+//   "CWRL" u8:version  seed  cell_px  ms_per_step  u64le:density-bits  u8:wrap  max_age  win_w  win_h
+//     u8:neighborhood  rule-birth-mask  rule-survive-mask  u64le:birth_p u64le:survive_p u64le:noise (bits)
+//     u8:engine  lenia-radius  u64le:lenia_mu u64le:lenia_sigma u64le:lenia_dt (bits)
+//   then records:  u8:kind  dt_us  dgen  payload
+// dt_us/dgen are deltas from the previous record (time since run start, generations completed).
+// Coordinates are zigzag-encoded. The log ends with an End record carrying the final time/generation.
+// Older logs (version 1: no Hash records; version 2: no key modifiers; version 3: Moore B3/S23 only;
+// version 4: deterministic rules only; version 5: no Lenia) still replay.
+
+enum class RecKind : uint8_t {
+    End = 0, Quit = 1, Resize = 2, KeyDown = 3, ButtonDown = 4, ButtonUp = 5, Motion = 6,
+    Hash = 7, // u64le grid checksum right after the step that produced `gen` (version >= 2)
+};
+
+static constexpr uint8_t kInputLogVersion = 6; // 6: header carries the engine and the Lenia parameters
+
+static void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back((uint8_t)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((uint8_t)v);
+}
+
+static uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+static int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+struct ByteReader {
+    const uint8_t* p = nullptr;
+    const uint8_t* end = nullptr;
+    bool ok = true;
+
+    uint8_t byte() {
+        if (p >= end) { ok = false; return 0; }
+        return *p++;
+    }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            uint8_t b = byte();
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+    uint64_t u64le() {
+        uint64_t v = 0;
+        for (int i = 0; i < 8; ++i) v |= (uint64_t)byte() << (8 * i);
+        return v;
+    }
+};
+
+// Buffers records in a reserved block and hands them to stdio in large writes; record() does not
+// allocate once the buffer is reserved.
+class InputRecorder {
+public:
+    ~InputRecorder() { close(); }
+
+    bool open(const std::string& path, uint64_t seed, const Config& cfg, int win_w, int win_h) {
+        f_ = std::fopen(path.c_str(), "wb");
+        if (!f_) return false;
+        buf_.reserve(kFlushAt + 64);
+
+        buf_.insert(buf_.end(), {'C', 'W', 'R', 'L', kInputLogVersion});
+        putVarint(buf_, seed);
+        putVarint(buf_, (uint64_t)cfg.cell_px);
+        putVarint(buf_, (uint64_t)cfg.ms_per_step);
+        uint64_t bits = 0;
+        std::memcpy(&bits, &cfg.density, sizeof(bits));
+        for (int i = 0; i < 8; ++i) buf_.push_back((uint8_t)(bits >> (8 * i)));
+        buf_.push_back(cfg.wrap ? 1 : 0);
+        putVarint(buf_, (uint64_t)cfg.max_age);
+        putVarint(buf_, (uint64_t)win_w);
+        putVarint(buf_, (uint64_t)win_h);
+        buf_.push_back((uint8_t)cfg.neighborhood);
+        putVarint(buf_, cfg.rule.birth);
+        putVarint(buf_, cfg.rule.survive);
+        for (double p : {cfg.birth_p, cfg.survive_p, cfg.noise}) {
+            std::memcpy(&bits, &p, sizeof(bits));
+            for (int i = 0; i < 8; ++i) buf_.push_back((uint8_t)(bits >> (8 * i)));
+        }
+        buf_.push_back((uint8_t)cfg.engine);
+        putVarint(buf_, (uint64_t)cfg.lenia_radius);
+        for (double p : {cfg.lenia_mu, cfg.lenia_sigma, cfg.lenia_dt}) {
+            std::memcpy(&bits, &p, sizeof(bits));
+            for (int i = 0; i < 8; ++i) buf_.push_back((uint8_t)(bits >> (8 * i)));
+        }
+        return true;
+    }
+
+    bool isOpen() const { return f_ != nullptr; }
+
+    // Records the events main() acts on; everything else is dropped.
+    void record(const SDL_Event& e, uint64_t t_us, uint64_t gen) {
+        if (!f_) return;
+        switch (e.type) {
+            case SDL_QUIT:
+                header(RecKind::Quit, t_us, gen);
+                break;
+            case SDL_WINDOWEVENT:
+                if (e.window.event != SDL_WINDOWEVENT_SIZE_CHANGED && e.window.event != SDL_WINDOWEVENT_RESIZED) return;
+                header(RecKind::Resize, t_us, gen);
+                putVarint(buf_, (uint64_t)std::max(0, e.window.data1));
+                putVarint(buf_, (uint64_t)std::max(0, e.window.data2));
+                break;
+            case SDL_KEYDOWN:
+                header(RecKind::KeyDown, t_us, gen);
+                putVarint(buf_, (uint32_t)e.key.keysym.sym);
+                putVarint(buf_, e.key.keysym.mod);
+                break;
+            case SDL_MOUSEBUTTONDOWN:
+            case SDL_MOUSEBUTTONUP:
+                header(e.type == SDL_MOUSEBUTTONDOWN ? RecKind::ButtonDown : RecKind::ButtonUp, t_us, gen);
+                buf_.push_back(e.button.button);
+                putVarint(buf_, zigzag(e.button.x));
+                putVarint(buf_, zigzag(e.button.y));
+                break;
+            case SDL_MOUSEMOTION:
+                header(RecKind::Motion, t_us, gen);
+                putVarint(buf_, zigzag(e.motion.x));
+                putVarint(buf_, zigzag(e.motion.y));
+                break;
+            default:
+                return;
+        }
+        ++events_;
+        if (buf_.size() >= kFlushAt) flush();
+    }
+
+    void recordHash(uint64_t hash, uint64_t t_us, uint64_t gen) {
+        if (!f_) return;
+        header(RecKind::Hash, t_us, gen);
+        for (int i = 0; i < 8; ++i) buf_.push_back((uint8_t)(hash >> (8 * i)));
+        if (buf_.size() >= kFlushAt) flush();
+    }
+
+    void finish(uint64_t t_us, uint64_t gen) {
+        if (!f_) return;
+        header(RecKind::End, t_us, gen);
+        close();
+    }
+
+    uint64_t events() const { return events_; }
+
+private:
+    static constexpr size_t kFlushAt = 64 * 1024;
+
+    void header(RecKind k, uint64_t t_us, uint64_t gen) {
+        buf_.push_back((uint8_t)k);
+        putVarint(buf_, t_us - std::min(t_us, last_t_));
+        putVarint(buf_, gen - std::min(gen, last_gen_));
+        last_t_ = t_us;
+        last_gen_ = gen;
+    }
+
+    void flush() {
+        if (f_ && !buf_.empty()) std::fwrite(buf_.data(), 1, buf_.size(), f_);
+        buf_.clear();
+    }
+
+    void close() {
+        if (!f_) return;
+        flush();
+        std::fclose(f_);
+        f_ = nullptr;
+    }
+
+    std::FILE* f_ = nullptr;
+    std::vector<uint8_t> buf_;
+    uint64_t last_t_ = 0, last_gen_ = 0;
+    uint64_t events_ = 0;
+};
+
+struct LoggedEvent {
+    uint64_t t_us = 0;
+    uint64_t gen = 0;
+    bool end = false;
+    bool has_hash = false; // checksum record, not an event
+    uint64_t hash = 0;
+    SDL_Event e{};
+};
+
+struct InputLog {
+    uint64_t seed = 0;
+    Config cfg;
+    int win_w = 0, win_h = 0;
+    std::vector<LoggedEvent> events; // always terminated by an End record
+};
+
+static bool loadInputLog(const std::string& path, InputLog& log, std::string& err) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) { err = "cannot open " + path; return false; }
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+
+    ByteReader r{data.data(), data.data() + data.size()};
+    if (data.size() < 5 || std::memcmp(data.data(), "CWRL", 4) != 0) { err = "not an input log"; return false; }
+    r.p += 4;
+    uint8_t version = r.byte();
+    if (version < 1 || version > kInputLogVersion) { err = "unsupported input log version"; return false; }
+
+    log.seed = r.varint();
+    log.cfg.cell_px = (int)r.varint();
+    log.cfg.ms_per_step = (int)r.varint();
+    uint64_t bits = r.u64le();
+    std::memcpy(&log.cfg.density, &bits, sizeof(bits));
+    log.cfg.wrap = r.byte() != 0;
+    log.cfg.max_age = (int)r.varint();
+    log.win_w = (int)r.varint();
+    log.win_h = (int)r.varint();
+    if (version >= 4) {
+        uint8_t nb = r.byte();
+        if (nb > (uint8_t)Neighborhood::Hex) { err = "unknown neighbourhood"; return false; }
+        log.cfg.neighborhood = (Neighborhood)nb;
+        log.cfg.rule.birth = (uint16_t)r.varint();
+        log.cfg.rule.survive = (uint16_t)r.varint();
+    }
+    if (version >= 5) {
+        for (double* p : {&log.cfg.birth_p, &log.cfg.survive_p, &log.cfg.noise}) {
+            bits = r.u64le();
+            std::memcpy(p, &bits, sizeof(bits));
+        }
+    }
+    if (version >= 6) {
+        uint8_t engine = r.byte();
+        if (engine > (uint8_t)Engine::Lenia) { err = "unknown engine"; return false; }
+        log.cfg.engine = (Engine)engine;
+        log.cfg.lenia_radius = (int)std::min<uint64_t>(r.varint(), 256);
+        for (double* p : {&log.cfg.lenia_mu, &log.cfg.lenia_sigma, &log.cfg.lenia_dt}) {
+            bits = r.u64le();
+            std::memcpy(p, &bits, sizeof(bits));
+        }
+    }
+    if (!r.ok || log.cfg.cell_px < 1 || log.win_w < 1 || log.win_h < 1) { err = "truncated header"; return false; }
+
+    uint64_t t = 0, gen = 0;
+    while (r.ok && r.p < r.end) {
+        LoggedEvent le;
+        auto kind = (RecKind)r.byte();
+        t += r.varint();
+        gen += r.varint();
+        le.t_us = t;
+        le.gen = gen;
+        switch (kind) {
+            case RecKind::End:
+                le.end = true;
+                break;
+            case RecKind::Quit:
+                le.e.type = SDL_QUIT;
+                break;
+            case RecKind::Resize:
+                le.e.type = SDL_WINDOWEVENT;
+                le.e.window.event = SDL_WINDOWEVENT_SIZE_CHANGED;
+                le.e.window.data1 = (int)r.varint();
+                le.e.window.data2 = (int)r.varint();
+                break;
+            case RecKind::KeyDown:
+                le.e.type = SDL_KEYDOWN;
+                le.e.key.keysym.sym = (SDL_Keycode)r.varint();
+                if (version >= 3) le.e.key.keysym.mod = (Uint16)r.varint();
+                break;
+            case RecKind::ButtonDown:
+            case RecKind::ButtonUp:
+                le.e.type = (kind == RecKind::ButtonDown) ? SDL_MOUSEBUTTONDOWN : SDL_MOUSEBUTTONUP;
+                le.e.button.button = r.byte();
+                le.e.button.x = (int)unzigzag(r.varint());
+                le.e.button.y = (int)unzigzag(r.varint());
+                break;
+            case RecKind::Motion:
+                le.e.type = SDL_MOUSEMOTION;
+                le.e.motion.x = (int)unzigzag(r.varint());
+                le.e.motion.y = (int)unzigzag(r.varint());
+                break;
+            case RecKind::Hash:
+                le.has_hash = true;
+                le.hash = r.u64le();
+                break;
+            default:
+                err = "corrupt record";
+                return false;
+        }
+        if (!r.ok) break;
+        log.events.push_back(le);
+        if (le.end) return true;
+    }
+
+    // Recording was cut short (crash, kill): replay what is there.
+    LoggedEvent end;
+    end.end = true;
+    end.t_us = t;
+    end.gen = gen;
+    log.events.push_back(end);
+    return true;
+}
+
+// ---------------- Metrics export (Prometheus text format) ----------------
+
+struct ProcessStats {
+    uint64_t rss_bytes = 0;
+    int threads = 0;
+};
+
+static ProcessStats readProcessStats() {
+    ProcessStats ps;
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) ps.rss_bytes = pmc.WorkingSetSize;
+
+    HANDLE snap = CreateToolhelp32Snapshot(TH32CS_SNAPTHREAD, 0);
+    if (snap != INVALID_HANDLE_VALUE) {
+        THREADENTRY32 te{};
+        te.dwSize = sizeof(te);
+        DWORD pid = GetCurrentProcessId();
+        for (BOOL ok = Thread32First(snap, &te); ok; ok = Thread32Next(snap, &te)) {
+            if (te.th32OwnerProcessID == pid) ++ps.threads;
+        }
+        CloseHandle(snap);
+    }
+#elif defined(__linux__)
+    std::ifstream f("/proc/self/status");
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.compare(0, 6, "VmRSS:") == 0) ps.rss_bytes = std::strtoull(line.c_str() + 6, nullptr, 10) * 1024;
+        else if (line.compare(0, 8, "Threads:") == 0) ps.threads = std::atoi(line.c_str() + 8);
+    }
+#endif
+    return ps;
+}
+
+// Replace `dst` with `tmp` in one step, so readers never observe a half-written file.
+static bool atomicReplaceFile(const std::string& tmp, const std::string& dst) {
+#ifdef _WIN32
+    return MoveFileExA(tmp.c_str(), dst.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(tmp.c_str(), dst.c_str()) == 0;
+#endif
+}
+
+static void writeSummary(std::ostream& os, const char* name, const char* help, const LatencyHistogram& h) {
+    os << "# HELP " << name << " " << help << "\n"
+       << "# TYPE " << name << " summary\n";
+    for (double q : {0.5, 0.9, 0.99, 0.999}) {
+        os << name << "{quantile=\"" << q << "\"} " << (double)h.percentile(q * 100.0) / 1e9 << "\n";
+    }
+    os << name << "_sum " << (double)h.sum_ns.get() / 1e9 << "\n"
+       << name << "_count " << h.count() << "\n";
+}
+
+static void writeMetric(std::ostream& os, const char* name, const char* type, const char* help, double v) {
+    os << "# HELP " << name << " " << help << "\n"
+       << "# TYPE " << name << " " << type << "\n"
+       << name << " " << v << "\n";
+}
+
+// Periodically writes FrameStats to a textfile-collector file from a low-priority thread. Reads
+// only the single-writer counters the main loop already maintains; the hot path takes no locks.
+class MetricsExporter {
+public:
+    MetricsExporter(const FrameStats& stats, std::string path, int interval_ms)
+        : stats_(stats), path_(std::move(path)), interval_ms_(std::max(100, interval_ms)) {
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~MetricsExporter() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+private:
+    void run() {
+        SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+
+        auto last_t = std::chrono::steady_clock::now();
+        uint64_t last_gen = stats_.generation.get();
+        uint64_t last_frames = stats_.frame.count();
+
+        std::unique_lock<std::mutex> lk(m_);
+        for (;;) {
+            bool stopping = cv_.wait_for(lk, std::chrono::milliseconds(interval_ms_), [this] { return stop_; });
+
+            auto t = std::chrono::steady_clock::now();
+            double dt = std::max(1e-9, (double)elapsedNs(last_t, t) / 1e9);
+            uint64_t gen = stats_.generation.get();
+            uint64_t frames = stats_.frame.count();
+            writeOnce((double)(gen - last_gen) / dt, (double)(frames - last_frames) / dt);
+            last_t = t;
+            last_gen = gen;
+            last_frames = frames;
+
+            if (stopping) return;
+        }
+    }
+
+    void writeOnce(double gen_rate, double fps) {
+        ProcessStats ps = readProcessStats();
+
+        std::ostringstream os;
+        os << std::setprecision(9);
+        writeMetric(os, "conway_generations_total", "counter", "Generations stepped since start.",
+                    (double)stats_.generation.get());
+        writeMetric(os, "conway_generation_rate", "gauge", "Generations per second over the last interval.", gen_rate);
+        writeMetric(os, "conway_fps", "gauge", "Frames presented per second over the last interval.", fps);
+        writeMetric(os, "conway_frames_missed_total", "counter", "Frames longer than the frame deadline.",
+                    (double)stats_.frames_missed.get());
+        writeSummary(os, "conway_frame_seconds", "Frame duration.", stats_.frame);
+        writeSummary(os, "conway_step_seconds", "Generation step duration.", stats_.step);
+        if (stats_.present.count()) {
+            writeSummary(os, "conway_raster_seconds", "Rasterisation to the staging buffers.", stats_.raster);
+            writeSummary(os, "conway_upload_seconds", "Staging buffer upload to the textures.", stats_.upload);
+            writeSummary(os, "conway_present_seconds", "Clear, copy and present.", stats_.present);
+            uint64_t busy = stats_.step_busy_ns.get();
+            writeMetric(os, "conway_step_overlap_ratio", "gauge", "Share of step time that overlapped drawing.",
+                        busy ? (double)stats_.step_overlap_ns.get() / (double)busy : 0.0);
+        }
+        if (stats_.snapshot.count()) {
+            writeSummary(os, "conway_checkpoint_snapshot_seconds", "Main-thread checkpoint snapshot duration.",
+                         stats_.snapshot);
+        }
+        writeMetric(os, "conway_population", "gauge", "Live cells after the last step.",
+                    (double)stats_.population.get());
+        writeMetric(os, "conway_grid_hash32", "gauge",
+                    "Low 32 bits of the current generation's grid checksum (exact as a float).",
+                    (double)(stats_.grid_hash.get() & 0xFFFFFFFFu));
+        writeMetric(os, "conway_grid_cells", "gauge", "Cells in the grid.",
+                    (double)(stats_.grid_w.get() * stats_.grid_h.get()));
+        os << "# HELP conway_engine_info Active stepping engine.\n"
+           << "# TYPE conway_engine_info gauge\n"
+           << "conway_engine_info{engine=\"" << stats_.engine << "\",neighborhood=\"" << stats_.neighborhood << "\"} 1\n";
+        os << "# HELP conway_memory_bytes Memory held per subsystem.\n"
+           << "# TYPE conway_memory_bytes gauge\n";
+        for (int k = 0; k < kMemoryKinds; ++k) {
+            os << "conway_memory_bytes{subsystem=\"" << memoryKindName((MemoryKind)k) << "\"} "
+               << (double)stats_.memory[(size_t)k].get() << "\n";
+        }
+        if (stats_.memory_budget.get()) {
+            writeMetric(os, "conway_memory_budget_bytes", "gauge", "Configured memory budget.",
+                        (double)stats_.memory_budget.get());
+        }
+        writeMetric(os, "conway_threads", "gauge", "Threads in the process.", (double)ps.threads);
+        writeMetric(os, "conway_resident_memory_bytes", "gauge", "Resident set size.", (double)ps.rss_bytes);
+
+        std::string tmp = path_ + ".tmp";
+        {
+            std::ofstream f(tmp, std::ios::binary | std::ios::trunc);
+            if (!f) return;
+            f << os.str();
+            if (!f.flush()) return;
+        }
+        if (!atomicReplaceFile(tmp, path_)) std::remove(tmp.c_str());
+    }
+
+    const FrameStats& stats_;
+    std::string path_;
+    int interval_ms_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+// ---------------- Energy (RAPL) ----------------
+//
+// Benchmarks and soaks read the RAPL energy counters that Linux exposes through powercap
+// (/sys/class/powercap/intel-rapl:P for package P, intel-rapl:P:K for its sub-domains, "dram"
+// among them; AMD Zen registers under the same name). Counters are cumulative microjoules that
+// wrap at max_energy_range_uj, so they must be sampled at least once per wrap (minutes at full
+// load): the benchmark loop samples every second, the soak sampler every interval. Since Linux
+// 5.10 energy_uj is readable by root only; the meter then reports why it is unavailable and
+// everything else carries on.
+
+struct EnergyTotals {
+    double package_j = 0, dram_j = 0;
+};
+
+class EnergyMeter {
+public:
+    explicit EnergyMeter(const std::string& root = "/sys/class/powercap") {
+#if defined(__linux__)
+        for (int p = 0; p < 64; ++p) {
+            std::string pkg = root + "/intel-rapl:" + std::to_string(p);
+            if (!addDomain(pkg)) break;
+            for (int k = 0; k < 16; ++k) addDomain(pkg + ":" + std::to_string(k));
+        }
+        if (domains_.empty() && status_.empty()) status_ = "no RAPL domains under " + root;
+#else
+        (void)root;
+        status_ = "RAPL counters are only read on Linux";
+#endif
+    }
+
+    bool available() const { return !domains_.empty(); }
+    bool hasDram() const {
+        for (const auto& d : domains_) if (d.dram) return true;
+        return false;
+    }
+    // Why nothing is measured, when !available().
+    const std::string& status() const { return status_; }
+
+    // Energy since construction. The soak sampler and the main thread both call it.
+    EnergyTotals sample() {
+        std::lock_guard<std::mutex> lk(m_);
+        EnergyTotals t;
+        for (auto& d : domains_) {
+            uint64_t raw = 0;
+            if (readCounter(d.counter, raw)) {
+                d.total_uj += raw >= d.last_uj ? raw - d.last_uj : raw + d.range_uj - d.last_uj;
+                d.last_uj = raw;
+            }
+            (d.dram ? t.dram_j : t.package_j) += (double)d.total_uj / 1e6;
+        }
+        return t;
+    }
+
+private:
+    struct Domain {
+        std::string counter; // .../energy_uj, built once so sampling does not allocate
+        bool dram = false;
+        uint64_t range_uj = 0, last_uj = 0, total_uj = 0;
+    };
+
+    static bool readCounter(const std::string& path, uint64_t& out) {
+        std::FILE* f = std::fopen(path.c_str(), "r");
+        if (!f) return false;
+        unsigned long long v = 0;
+        bool ok = std::fscanf(f, "%llu", &v) == 1;
+        std::fclose(f);
+        if (ok) out = v;
+        return ok;
+    }
+
+    // False if the zone does not exist. Zones other than packages and DRAM (core, uncore, psys)
+    // are skipped: core and uncore are part of the package.
+    bool addDomain(const std::string& path) {
+        std::ifstream f(path + "/name");
+        std::string name;
+        if (!(f >> name)) return false;
+        bool dram = name == "dram";
+        if (!dram && name.compare(0, 7, "package") != 0) return true;
+        Domain d;
+        d.counter = path + "/energy_uj";
+        d.dram = dram;
+        if (!readCounter(d.counter, d.last_uj)) {
+            if (status_.empty()) {
+                status_ = d.counter + " is not readable (" + std::strerror(errno) +
+                          "; root only since Linux 5.10)";
+            }
+            return true;
+        }
+        if (!readCounter(path + "/max_energy_range_uj", d.range_uj) || d.range_uj == 0) d.range_uj = 1ull << 32;
+        domains_.push_back(d);
+        return true;
+    }
+
+    std::vector<Domain> domains_;
+    std::string status_;
+    std::mutex m_;
+};
+
+// "energy: package 12.3 J (4.56 mJ/generation, 1.23 mJ/frame, 15.2 W), dram ..." for one run.
+static void printEnergyReport(std::ostream& os, const EnergyMeter& meter, const EnergyTotals& used, double secs,
+                              uint64_t generations, uint64_t frames, const char* renderer) {
+    if (!meter.available()) {
+        os << "energy: not measured (" << meter.status() << ")\n";
+        return;
+    }
+    auto domain = [&](const char* name, double j) {
+        os << name << " " << std::fixed << std::setprecision(2) << j << " J ("
+           << std::setprecision(3) << (generations ? j * 1e3 / (double)generations : 0.0) << " mJ/generation, "
+           << (frames ? j * 1e3 / (double)frames : 0.0) << " mJ/frame, " << std::setprecision(1)
+           << (secs > 0 ? j / secs : 0.0) << " W)";
+    };
+    os << "energy (" << renderer << " renderer): ";
+    domain("package", used.package_j);
+    if (meter.hasDram()) {
+        os << ", ";
+        domain("dram", used.dram_j);
+    }
+    os << "\n";
+}
+
+// ---------------- Soak test ----------------
+//
+// --soak=S runs the benchmark loop (with synthetic input) for S seconds. A background thread
+// samples throughput, interval frame/step percentiles and memory every --soak-interval and
+// streams them as CSV. At the end the samples are tested for a downward throughput trend (least
+// squares slope, one-sided t-test) and for monotonic RSS growth (Mann-Kendall).
+
+struct SoakSample {
+    double t_s = 0;
+    uint64_t generation = 0;
+    double gen_rate = 0, fps = 0;
+    uint64_t frame_p50 = 0, frame_p99 = 0, step_p50 = 0, step_p99 = 0; // ns
+    uint64_t rss_bytes = 0, tracked_bytes = 0;
+    double package_w = 0, dram_w = 0; // 0 without RAPL
+};
+
+class SoakSampler {
+public:
+    SoakSampler(const FrameStats& stats, EnergyMeter& energy, std::FILE* csv, int interval_s, size_t expected_samples)
+        : stats_(stats), energy_(energy), csv_(csv), interval_s_(std::max(1, interval_s)) {
+        samples_.reserve(expected_samples + 2);
+        std::fprintf(csv_, "t_s,generation,gen_per_s,fps,frame_p50_ms,frame_p99_ms,step_p50_ms,step_p99_ms,"
+                           "rss_bytes,tracked_bytes,package_w,dram_w\n");
+        std::fflush(csv_);
+        thread_ = std::thread([this] { run(); });
+    }
+    ~SoakSampler() { stop(); }
+
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            if (stop_) return;
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+    // After stop().
+    const std::vector<SoakSample>& samples() const { return samples_; }
+
+private:
+    void run() {
+        auto t0 = std::chrono::steady_clock::now(), last_t = t0;
+        uint64_t last_gen = stats_.generation.get(), last_frames = stats_.frame.count();
+        EnergyTotals last_energy = energy_.sample();
+        auto frame_prev = std::make_unique<HistogramSnapshot>(), frame_now = std::make_unique<HistogramSnapshot>();
+        auto step_prev = std::make_unique<HistogramSnapshot>(), step_now = std::make_unique<HistogramSnapshot>();
+        frame_prev->take(stats_.frame);
+        step_prev->take(stats_.step);
+
+        std::unique_lock<std::mutex> lk(m_);
+        for (;;) {
+            bool stopping = cv_.wait_for(lk, std::chrono::seconds(interval_s_), [this] { return stop_; });
+            if (stopping) return; // a partial interval would skew the trend
+
+            auto t = std::chrono::steady_clock::now();
+            double dt = std::max(1e-9, (double)elapsedNs(last_t, t) / 1e9);
+            frame_now->take(stats_.frame);
+            step_now->take(stats_.step);
+            SoakSample smp;
+            smp.t_s = (double)elapsedNs(t0, t) / 1e9;
+            smp.generation = stats_.generation.get();
+            smp.gen_rate = (double)(smp.generation - last_gen) / dt;
+            smp.fps = (double)(stats_.frame.count() - last_frames) / dt;
+            smp.frame_p50 = frame_now->percentileSince(*frame_prev, 50.0);
+            smp.frame_p99 = frame_now->percentileSince(*frame_prev, 99.0);
+            smp.step_p50 = step_now->percentileSince(*step_prev, 50.0);
+            smp.step_p99 = step_now->percentileSince(*step_prev, 99.0);
+            smp.rss_bytes = readProcessStats().rss_bytes;
+            EnergyTotals energy = energy_.sample();
+            smp.package_w = (energy.package_j - last_energy.package_j) / dt;
+            smp.dram_w = (energy.dram_j - last_energy.dram_j) / dt;
+            last_energy = energy;
+            for (const auto& m : stats_.memory) smp.tracked_bytes += m.get();
+            if (samples_.size() < samples_.capacity()) samples_.push_back(smp);
+            std::fprintf(csv_, "%.1f,%llu,%.2f,%.2f,%.3f,%.3f,%.3f,%.3f,%llu,%llu,%.2f,%.2f\n", smp.t_s,
+                         (unsigned long long)smp.generation, smp.gen_rate, smp.fps, (double)smp.frame_p50 / 1e6,
+                         (double)smp.frame_p99 / 1e6, (double)smp.step_p50 / 1e6, (double)smp.step_p99 / 1e6,
+                         (unsigned long long)smp.rss_bytes, (unsigned long long)smp.tracked_bytes, smp.package_w,
+                         smp.dram_w);
+            std::fflush(csv_);
+
+            last_t = t;
+            last_gen = smp.generation;
+            last_frames = stats_.frame.count();
+            std::swap(frame_prev, frame_now);
+            std::swap(step_prev, step_now);
+        }
+    }
+
+    const FrameStats& stats_;
+    EnergyMeter& energy_;
+    std::FILE* csv_;
+    int interval_s_;
+    std::vector<SoakSample> samples_; // sampler thread until stop()
+    std::mutex m_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+// One-sided 95% critical value of Student's t with df degrees of freedom.
+static double tCritical95(int df) {
+    static const double table[] = {6.314, 2.920, 2.353, 2.132, 2.015, 1.943, 1.895, 1.860, 1.833, 1.812};
+    if (df < 1) return INFINITY;
+    if (df <= 10) return table[df - 1];
+    return 1.645 + 1.6 / df;
+}
+
+// Analyses the samples after the first 10% (warm-up). False if a regression was flagged. Drift needs
+// both significance and a fitted drop of at least 1% over the run, so a long run is not flagged for
+// a negligible but detectable slope; memory growth needs Mann-Kendall significance and 1 MiB.
+static bool reportSoak(std::ostream& os, const std::vector<SoakSample>& all, double duration_s) {
+    size_t skip = all.size() / 10;
+    std::vector<SoakSample> v(all.begin() + (std::ptrdiff_t)skip, all.end());
+    os << "soak: " << std::fixed << std::setprecision(0) << duration_s << " s, " << all.size() << " samples ("
+       << skip << " warm-up)\n";
+    if (v.size() < 4) {
+        os << "soak: too few samples for trend tests; lengthen --soak or shorten --soak-interval\n";
+        return true;
+    }
+    const double n = (double)v.size();
+
+    double mt = 0, mr = 0;
+    for (const auto& s : v) { mt += s.t_s; mr += s.gen_rate; }
+    mt /= n;
+    mr /= n;
+    double sxx = 0, sxy = 0;
+    for (const auto& s : v) {
+        sxx += (s.t_s - mt) * (s.t_s - mt);
+        sxy += (s.t_s - mt) * (s.gen_rate - mr);
+    }
+    double slope = sxx > 0 ? sxy / sxx : 0.0, sse = 0;
+    for (const auto& s : v) {
+        double e = s.gen_rate - (mr + slope * (s.t_s - mt));
+        sse += e * e;
+    }
+    double se = sxx > 0 ? std::sqrt(sse / (n - 2) / sxx) : 0.0;
+    double t = se > 0 ? slope / se : (slope < 0 ? -INFINITY : 0.0);
+    double span = v.back().t_s - v.front().t_s;
+    double drop_pct = mr > 0 ? -100.0 * slope * span / mr : 0.0;
+    bool drift = t < -tCritical95((int)v.size() - 2) && drop_pct >= 1.0;
+    os << "soak: throughput " << std::setprecision(1) << mr << " gen/s mean, trend " << std::setprecision(2)
+       << std::showpos << (mr > 0 ? 100.0 * slope * 3600.0 / mr : 0.0) << " %/h, " << -drop_pct
+       << "% over the run" << std::noshowpos << " (t=" << t << "): " << (drift ? "DRIFTING DOWN" : "ok") << "\n";
+
+    int64_t mk = 0;
+    for (size_t i = 0; i < v.size(); ++i) {
+        for (size_t j = i + 1; j < v.size(); ++j) mk += (v[j].rss_bytes > v[i].rss_bytes) - (v[j].rss_bytes < v[i].rss_bytes);
+    }
+    double var = n * (n - 1) * (2 * n + 5) / 18.0;
+    double z = mk > 0 ? (double)(mk - 1) / std::sqrt(var) : mk < 0 ? (double)(mk + 1) / std::sqrt(var) : 0.0;
+    uint64_t first = v.front().rss_bytes, last = v.back().rss_bytes;
+    bool growth = z > 1.645 && last >= first + (1u << 20);
+    os << "soak: RSS " << std::setprecision(1) << mib(first) << " -> " << mib(last) << " MiB (Mann-Kendall z="
+       << std::setprecision(2) << z << "): " << (growth ? "GROWING" : "ok") << "\n";
+    os.flush();
+    return !drift && !growth;
+}
+
+// ---------------- Checkpointing ----------------
+//
+// File layout (little-endian):
+//   "CWCK" u8:version u32:w u32:h u64:generation u64:packed-size  packed-ages  u64:hash(packed-ages)
+// Ages are PackBits-style run-length coded: control byte c < 128 is followed by c+1 literal bytes,
+// c >= 128 by one byte repeated c-125 times (3..130).
+
+static constexpr uint8_t kCheckpointVersion = 1;
+
+static size_t packBitsBound(size_t n) { return n + n / 128 + 1; }
+
+// `out` must hold packBitsBound(n) bytes; returns the packed size.
+static size_t packBits(const uint8_t* in, size_t n, uint8_t* out) {
+    size_t o = 0, i = 0;
+    while (i < n) {
+        size_t run = 1;
+        while (i + run < n && run < 130 && in[i + run] == in[i]) ++run;
+        if (run >= 3) {
+            out[o++] = (uint8_t)(run + 125);
+            out[o++] = in[i];
+            i += run;
+            continue;
+        }
+        // Literal block up to the next run of three.
+        size_t lit = 0;
+        while (i + lit < n && lit < 128) {
+            if (i + lit + 2 < n && in[i + lit] == in[i + lit + 1] && in[i + lit] == in[i + lit + 2]) break;
+            ++lit;
+        }
+        out[o++] = (uint8_t)(lit - 1);
+        std::memcpy(out + o, in + i, lit);
+        o += lit;
+        i += lit;
+    }
+    return o;
+}
+
+// Returns false on malformed input or if the output would not be exactly n bytes.
+static bool unpackBits(const uint8_t* in, size_t in_n, uint8_t* out, size_t n) {
+    size_t i = 0, o = 0;
+    while (i < in_n) {
+        uint8_t c = in[i++];
+        if (c < 128) {
+            size_t lit = (size_t)c + 1;
+            if (i + lit > in_n || o + lit > n) return false;
+            std::memcpy(out + o, in + i, lit);
+            i += lit;
+            o += lit;
+        } else {
+            size_t run = (size_t)c - 125;
+            if (i >= in_n || o + run > n) return false;
+            std::memset(out + o, in[i++], run);
+            o += run;
+        }
+    }
+    return o == n;
+}
+
+static uint64_t hashBytes(const uint8_t* p, size_t n) {
+    uint64_t h = kP5 + n;
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) h = hashRound(h, load64(p + i));
+    uint64_t tail = 0;
+    std::memcpy(&tail, p + i, n - i);
+    return avalanche64(hashRound(h, tail));
+}
+
+static void putLE(std::vector<uint8_t>& out, uint64_t v, int bytes) {
+    for (int i = 0; i < bytes; ++i) out.push_back((uint8_t)(v >> (8 * i)));
+}
+
+// Write `data` to `path` durably: write, fsync, rename over the target, fsync the directory.
+// Uses io_uring (linked write + fsync) where the build has liburing and the kernel allows it.
+static bool writeFileDurably(const std::string& path, const uint8_t* data, size_t n) {
+    std::string tmp = path + ".tmp";
+#ifdef _WIN32
+    std::FILE* f = std::fopen(tmp.c_str(), "wb");
+    if (!f) return false;
+    bool ok = std::fwrite(data, 1, n, f) == n && std::fflush(f) == 0 &&
+              FlushFileBuffers((HANDLE)_get_osfhandle(_fileno(f)));
+    std::fclose(f);
+#else
+    int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) return false;
+    bool ok = false;
+    bool done = false;
+#ifdef CONWAY_HAVE_LIBURING
+    io_uring ring;
+    if (io_uring_queue_init(4, &ring, 0) == 0) {
+        done = true;
+        ok = true;
+        size_t off = 0;
+        while (ok && off < n) {
+            io_uring_sqe* w = io_uring_get_sqe(&ring);
+            io_uring_prep_write(w, fd, data + off, (unsigned)std::min<size_t>(n - off, 1u << 30), off);
+            io_uring_cqe* cqe = nullptr;
+            ok = io_uring_submit_and_wait(&ring, 1) >= 0 && io_uring_wait_cqe(&ring, &cqe) == 0 && cqe->res > 0;
+            if (ok) off += (size_t)cqe->res;
+            if (cqe) io_uring_cqe_seen(&ring, cqe);
+        }
+        if (ok) {
+            io_uring_sqe* fs = io_uring_get_sqe(&ring);
+            io_uring_prep_fsync(fs, fd, 0);
+            io_uring_cqe* cqe = nullptr;
+            ok = io_uring_submit_and_wait(&ring, 1) >= 0 && io_uring_wait_cqe(&ring, &cqe) == 0 && cqe->res == 0;
+            if (cqe) io_uring_cqe_seen(&ring, cqe);
+        }
+        io_uring_queue_exit(&ring);
+    }
+#endif
+    if (!done) {
+        ok = true;
+        size_t off = 0;
+        while (ok && off < n) {
+            ssize_t k = ::write(fd, data + off, n - off);
+            if (k > 0) off += (size_t)k;
+            else ok = (k < 0 && errno == EINTR);
+        }
+        ok = ok && ::fsync(fd) == 0;
+    }
+    ok = (::close(fd) == 0) && ok;
+#endif
+    if (!ok || !atomicReplaceFile(tmp, path)) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+#ifndef _WIN32
+    auto slash = path.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "." : path.substr(0, std::max<size_t>(slash, 1));
+    int dfd = ::open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (dfd >= 0) {
+        ::fsync(dfd);
+        ::close(dfd);
+    }
+#endif
+    return true;
+}
+
+struct Checkpoint {
+    int w = 0, h = 0;
+    uint64_t generation = 0;
+    std::vector<uint8_t> ages;
+};
+
+static bool loadCheckpoint(const std::string& path, Checkpoint& ck) {
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return false;
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+    if (data.size() < 37 || std::memcmp(data.data(), "CWCK", 4) != 0 || data[4] != kCheckpointVersion) return false;
+
+    auto le = [&](size_t at, int bytes) {
+        uint64_t v = 0;
+        for (int i = 0; i < bytes; ++i) v |= (uint64_t)data[at + i] << (8 * i);
+        return v;
+    };
+    ck.w = (int)le(5, 4);
+    ck.h = (int)le(9, 4);
+    ck.generation = le(13, 8);
+    uint64_t packed = le(21, 8);
+    if (ck.w < 1 || ck.h < 1 || packed != data.size() - 37) return false;
+    const uint8_t* p = data.data() + 29;
+    if (hashBytes(p, (size_t)packed) != le(29 + (size_t)packed, 8)) return false;
+
+    ck.ages.resize((size_t)ck.w * ck.h);
+    return unpackBits(p, (size_t)packed, ck.ages.data(), ck.ages.size());
+}
+
+// Periodic checkpoints off the main thread. The main thread only copies the grid into a pooled
+// buffer (skipping the checkpoint if the previous one is still being written); packing and the
+// durable write happen on a background I/O thread.
+class CheckpointWriter {
+public:
+    CheckpointWriter(std::string path, size_t max_cells) : path_(std::move(path)) {
+        snap_.reserve(max_cells);
+        out_.reserve(37 + packBitsBound(max_cells));
+        out_reserved_ = out_.capacity();
+        thread_ = std::thread([this] { run(); });
+    }
+
+    ~CheckpointWriter() {
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            stop_ = true;
+        }
+        cv_.notify_all();
+        thread_.join();
+    }
+
+    // Main thread. Returns false (and does nothing) while the previous checkpoint is in flight.
+    bool trySnapshot(const std::vector<uint8_t>& g, int w, int h, uint64_t generation) {
+        if (busy_.load(std::memory_order_acquire)) return false;
+        snap_.assign(g.begin(), g.end());
+        w_ = w;
+        h_ = h;
+        gen_ = generation;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            busy_.store(true, std::memory_order_release);
+        }
+        cv_.notify_one();
+        return true;
+    }
+
+    void waitIdle() {
+        while (busy_.load(std::memory_order_acquire)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    uint64_t written() const { return written_.get(); }
+    uint64_t failed() const { return failed_.get(); }
+    uint64_t lastBytes() const { return last_bytes_.get(); }
+    uint64_t lastWriteNs() const { return last_write_ns_.get(); }
+    // Main thread. out_ only outgrows its reservation if the grid outgrows the reserved size.
+    size_t bytes() const { return snap_.capacity() + out_reserved_; }
+
+private:
+    void run() {
+        SDL_SetThreadPriority(SDL_THREAD_PRIORITY_LOW);
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lk(m_);
+                cv_.wait(lk, [this] { return stop_ || busy_.load(std::memory_order_acquire); });
+                if (!busy_.load(std::memory_order_acquire)) return; // stopping with nothing pending
+            }
+            auto t0 = std::chrono::steady_clock::now();
+
+            out_.clear();
+            out_.insert(out_.end(), {'C', 'W', 'C', 'K', kCheckpointVersion});
+            putLE(out_, (uint64_t)w_, 4);
+            putLE(out_, (uint64_t)h_, 4);
+            putLE(out_, gen_, 8);
+            size_t at_size = out_.size();
+            putLE(out_, 0, 8);
+            size_t body = out_.size();
+            out_.resize(body + packBitsBound(snap_.size()));
+            size_t packed = packBits(snap_.data(), snap_.size(), out_.data() + body);
+            out_.resize(body + packed);
+            for (int i = 0; i < 8; ++i) out_[at_size + i] = (uint8_t)((uint64_t)packed >> (8 * i));
+            putLE(out_, hashBytes(out_.data() + body, packed), 8);
+
+            if (writeFileDurably(path_, out_.data(), out_.size())) {
+                written_.add(1);
+                last_bytes_.set(out_.size());
+            } else {
+                failed_.add(1);
+            }
+            last_write_ns_.set(elapsedNs(t0, std::chrono::steady_clock::now()));
+            busy_.store(false, std::memory_order_release);
+        }
+    }
+
+    std::string path_;
+    std::vector<uint8_t> snap_; // owned by the main thread unless busy_
+    std::vector<uint8_t> out_;  // I/O thread only
+    size_t out_reserved_ = 0;
+    int w_ = 0, h_ = 0;
+    uint64_t gen_ = 0;
+    std::atomic<bool> busy_{false};
+    RelaxedCounter written_, failed_, last_bytes_, last_write_ns_;
+    std::mutex m_;
+    std::condition_variable cv_;
+    bool stop_ = false;
+    std::thread thread_;
+};
+
+// ---------------- Pattern library (--build-library, --library) ----------------
+//
+// Seeds a universe with random placements of known patterns instead of a uniform soup. The library
+// is built once from .rle / .cells files and read through a memory map, so seeding parses no text.
+// File layout (little-endian, every offset a multiple of 8):
+//   "CWPL" u8:version u8[3]:0 u32:count u32:0  then `count` index entries  u64:offset u32:w u32:h
+//   then each pattern's bitplane at its offset: h rows of ceil(w/64) u64 words, bit x%64 of word
+//   x/64 set = cell x of the row is live.
+
+static constexpr uint8_t kLibraryVersion = 1;
+static constexpr size_t kLibraryHeader = 16;
+static constexpr size_t kLibraryEntry = 16;
+static constexpr int kLibraryMaxSide = 4096; // larger patterns are skipped when building
+
+static size_t libraryStride(int w) { return ((size_t)w + 63) / 64; }
+
+// A decoded pattern: live cells row by row, trimmed to its bounding box.
+struct LibraryPattern {
+    int w = 0, h = 0;
+    std::vector<uint64_t> bits;
+};
+
+static void trimPattern(std::vector<std::pair<int, int>>& cells, LibraryPattern& p) {
+    p = LibraryPattern{};
+    if (cells.empty()) return;
+    int x0 = INT32_MAX, y0 = INT32_MAX, x1 = 0, y1 = 0;
+    for (auto& c : cells) {
+        x0 = std::min(x0, c.first);
+        y0 = std::min(y0, c.second);
+        x1 = std::max(x1, c.first + 1);
+        y1 = std::max(y1, c.second + 1);
+    }
+    if (x1 - x0 > kLibraryMaxSide || y1 - y0 > kLibraryMaxSide) return;
+    p.w = x1 - x0;
+    p.h = y1 - y0;
+    size_t stride = libraryStride(p.w);
+    p.bits.assign(stride * (size_t)p.h, 0);
+    for (auto& c : cells) {
+        int x = c.first - x0, y = c.second - y0;
+        p.bits[(size_t)y * stride + (size_t)(x >> 6)] |= 1ull << (x & 63);
+    }
+}
+
+// Golly RLE: '#' lines are skipped and the "x = .., y = .., rule = .." header must come first. 'b'
+// and '.' are dead, 'o' and the multi-state letters A..X (with optional p..y prefixes) live, '$' ends
+// a row and '!' the pattern.
+static bool parseRlePattern(const std::string& text, LibraryPattern& p) {
+    std::vector<std::pair<int, int>> cells;
+    std::istringstream in(text);
+    std::string line;
+    int x = 0, y = 0;
+    bool header = false, done = false;
+    while (!done && std::getline(in, line)) {
+        size_t s = line.find_first_not_of(" \t\r");
+        if (s == std::string::npos || line[s] == '#') continue;
+        if (!header) {
+            if (line[s] != 'x') return false;
+            header = true;
+            continue;
+        }
+        uint64_t count = 0;
+        for (size_t i = s; i < line.size() && !done; ++i) {
+            char c = line[i];
+            if (c >= '0' && c <= '9') {
+                count = std::min<uint64_t>(count * 10 + (uint64_t)(c - '0'), 1u << 20);
+                continue;
+            }
+            if (c >= 'p' && c <= 'y') continue; // multi-state prefix; the letter after it decides
+            int n = count ? (int)count : 1;
+            count = 0;
+            if (c == 'b' || c == '.') {
+                x += n;
+            } else if (c == '$') {
+                y += n;
+                x = 0;
+            } else if (c == '!') {
+                done = true;
+            } else if (c == 'o' || (c >= 'A' && c <= 'X')) {
+                if (x + n > kLibraryMaxSide * 4 || y > kLibraryMaxSide * 4) return false;
+                for (int k = 0; k < n; ++k) cells.emplace_back(x++, y);
+            } else if (c != ' ' && c != '\t' && c != '\r') {
+                return false;
+            }
+        }
+    }
+    trimPattern(cells, p);
+    return p.w > 0;
+}
+
+// Plaintext (.cells): '!' lines are comments, 'O' or '*' is live, anything else dead.
+static bool parsePlaintextPattern(const std::string& text, LibraryPattern& p) {
+    std::vector<std::pair<int, int>> cells;
+    std::istringstream in(text);
+    std::string line;
+    int y = 0;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line[0] == '!') continue;
+        if (line.size() > (size_t)kLibraryMaxSide * 4 || y > kLibraryMaxSide * 4) return false;
+        for (size_t x = 0; x < line.size(); ++x) {
+            if (line[x] == 'O' || line[x] == '*') cells.emplace_back((int)x, y);
+        }
+        ++y;
+    }
+    trimPattern(cells, p);
+    return p.w > 0;
+}
+
+// Reads every .rle / .cells file under `sources` (files or directories, recursively) and writes the
+// library to `out`. Returns the process exit code.
+static int buildLibrary(const std::string& out, const std::vector<std::string>& sources) {
+    namespace fs = std::filesystem;
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<fs::path> files;
+    for (const auto& s : sources) {
+        std::error_code ec;
+        if (fs::is_directory(s, ec)) {
+            for (fs::recursive_directory_iterator it(s, ec), end; !ec && it != end; it.increment(ec)) {
+                if (it->is_regular_file(ec)) files.push_back(it->path());
+            }
+        } else {
+            files.emplace_back(s);
+        }
+        if (ec) std::cerr << "Cannot read '" << s << "': " << ec.message() << "\n";
+    }
+    std::sort(files.begin(), files.end());
+
+    std::vector<uint8_t> index, planes;
+    uint32_t count = 0;
+    uint64_t skipped = 0;
+    LibraryPattern p;
+    for (const auto& f : files) {
+        std::string ext = f.extension().string();
+        for (auto& ch : ext) ch = (char)std::tolower((unsigned char)ch);
+        if (ext != ".rle" && ext != ".cells") continue;
+        std::ifstream in(f, std::ios::binary);
+        std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        bool ok = in.good() || in.eof();
+        ok = ok && (ext == ".rle" ? parseRlePattern(text, p) : parsePlaintextPattern(text, p));
+        if (!ok) {
+            std::cerr << "Skipping " << f.string() << ": not a pattern, empty, or larger than "
+                      << kLibraryMaxSide << " cells on a side\n";
+            ++skipped;
+            continue;
+        }
+        putLE(index, planes.size(), 8); // relative to the first bitplane until the index size is known
+        putLE(index, (uint64_t)p.w, 4);
+        putLE(index, (uint64_t)p.h, 4);
+        for (uint64_t word : p.bits) putLE(planes, word, 8);
+        ++count;
+    }
+    if (!count) {
+        std::cerr << "--build-library: no .rle or .cells patterns found\n";
+        return 1;
+    }
+
+    std::vector<uint8_t> file;
+    file.reserve(kLibraryHeader + index.size() + planes.size());
+    file.insert(file.end(), {'C', 'W', 'P', 'L', kLibraryVersion, 0, 0, 0});
+    putLE(file, count, 4);
+    putLE(file, 0, 4);
+    const uint64_t base = kLibraryHeader + index.size();
+    for (size_t e = 0; e < index.size(); e += kLibraryEntry) {
+        uint64_t rel = 0;
+        for (int i = 0; i < 8; ++i) rel |= (uint64_t)index[e + i] << (8 * i);
+        putLE(file, base + rel, 8);
+        file.insert(file.end(), index.begin() + (std::ptrdiff_t)e + 8, index.begin() + (std::ptrdiff_t)(e + kLibraryEntry));
+    }
+    file.insert(file.end(), planes.begin(), planes.end());
+    if (!writeFileDurably(out, file.data(), file.size())) {
+        std::cerr << "Cannot write library '" << out << "'\n";
+        return 1;
+    }
+    std::cout << "library: " << count << " patterns (" << skipped << " files skipped) -> " << out << ", "
+              << file.size() << " bytes in " << std::fixed << std::setprecision(1)
+              << (double)elapsedNs(t0, std::chrono::steady_clock::now()) / 1e6 << " ms\n";
+    return 0;
+}
+
+// Read-only memory map of a whole file.
+class MappedFile {
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    bool open(const std::string& path, std::string& err) {
+        close();
+#ifdef _WIN32
+        HANDLE f = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (f == INVALID_HANDLE_VALUE) { err = "cannot open"; return false; }
+        LARGE_INTEGER sz{};
+        HANDLE m = nullptr;
+        if (GetFileSizeEx(f, &sz) && sz.QuadPart > 0)
+            m = CreateFileMappingA(f, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (m) {
+            data_ = (const uint8_t*)MapViewOfFile(m, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(m);
+        }
+        CloseHandle(f);
+        size_ = data_ ? (size_t)sz.QuadPart : 0;
+#else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) { err = std::strerror(errno); return false; }
+        struct stat st{};
+        if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+            void* p = ::mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                data_ = (const uint8_t*)p;
+                size_ = (size_t)st.st_size;
+            }
+        }
+        ::close(fd);
+#endif
+        if (!data_) err = "cannot map (empty file?)";
+        return data_ != nullptr;
+    }
+
+    void close() {
+        if (!data_) return;
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+#else
+        ::munmap((void*)data_, size_);
+#endif
+        data_ = nullptr;
+        size_ = 0;
+    }
+
+    const uint8_t* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// A mapped library. open() checks the header and that every entry lies inside the file; after that,
+// placing a pattern only reads its bitplane.
+class PatternLibrary {
+public:
+    bool open(const std::string& path, std::string& err) {
+        auto t0 = std::chrono::steady_clock::now();
+        if (!file_.open(path, err)) return false;
+        const uint8_t* d = file_.data();
+        size_t n = file_.size();
+        if (n < kLibraryHeader || std::memcmp(d, "CWPL", 4) != 0 || d[4] != kLibraryVersion) {
+            err = "not a pattern library (build one with --build-library)";
+            file_.close();
+            return false;
+        }
+        count_ = (uint32_t)load64(d + 8);
+        if (!count_ || (n - kLibraryHeader) / kLibraryEntry < count_) {
+            err = "truncated index";
+            file_.close();
+            return false;
+        }
+        for (uint32_t i = 0; i < count_; ++i) {
+            Entry e = entry(i);
+            if (e.w < 1 || e.h < 1 || e.w > kLibraryMaxSide || e.h > kLibraryMaxSide || e.offset > n ||
+                (n - e.offset) / 8 / libraryStride(e.w) < (uint64_t)e.h) {
+                err = "pattern " + std::to_string(i) + " lies outside the file";
+                file_.close();
+                return false;
+            }
+        }
+        open_ns_ = elapsedNs(t0, std::chrono::steady_clock::now());
+        return true;
+    }
+
+    uint32_t count() const { return count_; }
+    uint64_t openNs() const { return open_ns_; }
+
+    // ORs `n` randomly chosen patterns, each in one of the 8 rotations/reflections, into a w x h
+    // grid of ages at random positions (wrapping on a torus, fully inside otherwise). Patterns that
+    // do not fit are not placed. Returns the number placed.
+    int seed(std::vector<uint8_t>& g, int w, int h, bool wrap, int n, std::mt19937& rng) const {
+        int placed = 0;
+        for (int k = 0; k < n; ++k) {
+            Entry e = entry((uint32_t)(rng() % count_));
+            unsigned sym = rng() & 7;
+            bool transpose = sym & 4;
+            int tw = transpose ? e.h : e.w, th = transpose ? e.w : e.h;
+            uint32_t rx = rng(), ry = rng();
+            if (tw > w || th > h) continue;
+            int ox = (int)(rx % (uint32_t)(wrap ? w : w - tw + 1));
+            int oy = (int)(ry % (uint32_t)(wrap ? h : h - th + 1));
+            const uint8_t* plane = file_.data() + e.offset;
+            size_t stride = libraryStride(e.w);
+            for (int y = 0; y < e.h; ++y) {
+                for (size_t wi = 0; wi < stride; ++wi) {
+                    uint64_t bits = load64(plane + ((size_t)y * stride + wi) * 8);
+                    while (bits) {
+                        int x = (int)(wi * 64) + lowestBit(bits);
+                        bits &= bits - 1;
+                        int tx = transpose ? y : x, ty = transpose ? x : y;
+                        if (sym & 1) tx = tw - 1 - tx;
+                        if (sym & 2) ty = th - 1 - ty;
+                        int gx = ox + tx, gy = oy + ty;
+                        if (gx >= w) gx -= w;
+                        if (gy >= h) gy -= h;
+                        g[idx(gx, gy, w)] = 1;
+                    }
+                }
+            }
+            ++placed;
+        }
+        return placed;
+    }
+
+private:
+    struct Entry {
+        uint64_t offset;
+        int w, h;
+    };
+    Entry entry(uint32_t i) const {
+        const uint8_t* p = file_.data() + kLibraryHeader + (size_t)i * kLibraryEntry;
+        uint64_t wh = load64(p + 8);
+        return Entry{load64(p), (int)(uint32_t)wh, (int)(uint32_t)(wh >> 32)};
+    }
+
+    MappedFile file_;
+    uint32_t count_ = 0;
+    uint64_t open_ns_ = 0;
+};
+
+// ---------------- Delta stream (--serve, /v) ----------------
+//
+// --serve=[HOST:]PORT mirrors the primary universe to any number of viewers (/v HOST:PORT) over TCP.
+// Stream layout (integers LEB128 varints unless noted):
+//   "CWDS" u8:version, then messages:  u8:kind  size  payload[size]
+//   Keyframe: w  h  generation  u8:neighborhood  max_age  u8:flags  u64le:hash  packed-ages
+//   Delta:    generations  u8:flags  u64le:hash  runs
+// Keyframe ages are PackBits-coded as in checkpoints. Delta runs alternate unchanged / flipped cell
+// counts of the row-major liveness XOR against the previous message, starting with unchanged; cells
+// after the last run are unchanged. A delta therefore costs a few bytes per changed stretch of a
+// row, and a still universe costs a few bytes per generation. Viewers age their cells themselves.
+// With kStreamHashed, `hash` is the liveness checksum (GridHash) of the new grid.
+//
+// The main thread only offers each published generation: one copy into a reserved buffer, skipped
+// while nobody is connected or the server thread has not taken the previous one (the next delta then
+// spans several generations). The server thread encodes each delta once for all viewers. A viewer
+// whose unsent backlog would pass kStreamQueueBytes stops receiving deltas and resyncs from a
+// keyframe once the backlog has drained, so a slow viewer holds up neither the simulation nor the
+// other viewers.
+
+static constexpr uint8_t kStreamVersion = 1;
+static constexpr uint8_t kStreamKeyframe = 1, kStreamDelta = 2;
+static constexpr uint8_t kStreamHashed = 1;
+static constexpr size_t kStreamQueueBytes = (size_t)4 << 20;
+
+#ifdef _WIN32
+using SocketHandle = SOCKET;
+static constexpr SocketHandle kNoSocket = INVALID_SOCKET;
+static bool initSockets() {
+    WSADATA wsa;
+    return WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+}
+static void closeSocket(SocketHandle s) { closesocket(s); }
+static bool socketWouldBlock() { return WSAGetLastError() == WSAEWOULDBLOCK; }
+static void setNonBlocking(SocketHandle s) {
+    u_long on = 1;
+    ioctlsocket(s, FIONBIO, &on);
+}
+static int pollSockets(pollfd* fds, size_t n, int timeout_ms) { return WSAPoll(fds, (ULONG)n, timeout_ms); }
+#else
+using SocketHandle = int;
+static constexpr SocketHandle kNoSocket = -1;
+static bool initSockets() { return true; }
+static void closeSocket(SocketHandle s) { close(s); }
+static bool socketWouldBlock() { return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR; }
+static void setNonBlocking(SocketHandle s) { fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK); }
+static int pollSockets(pollfd* fds, size_t n, int timeout_ms) { return poll(fds, (nfds_t)n, timeout_ms); }
+#endif
+#ifdef MSG_NOSIGNAL
+static constexpr int kSendFlags = MSG_NOSIGNAL; // a viewer hanging up must not raise SIGPIPE
+#else
+static constexpr int kSendFlags = 0;
+#endif
+
+// A listening socket on HOST:PORT (empty host: all interfaces), or a connection to it.
+static SocketHandle openSocket(const std::string& host, int port, bool listening, std::string& err) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    if (listening) hints.ai_flags = AI_PASSIVE;
+    addrinfo* res = nullptr;
+    std::string service = std::to_string(port);
+    int rc = getaddrinfo(host.empty() ? nullptr : host.c_str(), service.c_str(), &hints, &res);
+    if (rc != 0) {
+        err = gai_strerror(rc);
+        return kNoSocket;
+    }
+    SocketHandle s = kNoSocket;
+    for (addrinfo* a = res; a && s == kNoSocket; a = a->ai_next) {
+        s = socket(a->ai_family, a->ai_socktype, a->ai_protocol);
+        if (s == kNoSocket) continue;
+        int one = 1;
+        if (listening) setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+        bool ok = listening ? bind(s, a->ai_addr, (socklen_t)a->ai_addrlen) == 0 && listen(s, 16) == 0
+                            : connect(s, a->ai_addr, (socklen_t)a->ai_addrlen) == 0;
+        if (!ok) {
+            err = std::strerror(errno);
+            closeSocket(s);
+            s = kNoSocket;
+            continue;
+        }
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+    }
+    freeaddrinfo(res);
+    return s;
+}
+
+// "[HOST:]PORT"
+static bool parseHostPort(const std::string& s, std::string& host, int& port) {
+    size_t colon = s.rfind(':');
+    host = colon == std::string::npos ? std::string() : s.substr(0, colon);
+    try {
+        size_t pos = 0;
+        std::string p = s.substr(colon == std::string::npos ? 0 : colon + 1);
+        long v = std::stol(p, &pos, 10);
+        if (pos != p.size() || v < 1 || v > 65535) return false;
+        port = (int)v;
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
+class DeltaServer {
+public:
+    ~DeltaServer() { stop(); }
+
+    // Listens and starts the server thread. `max_cells` sizes the frame buffers so offer() does not
+    // allocate.
+    bool start(const std::string& host, int port, size_t max_cells, std::string& err) {
+        if (!initSockets()) {
+            err = "socket initialisation failed";
+            return false;
+        }
+        listen_ = openSocket(host, port, true, err);
+        if (listen_ == kNoSocket) return false;
+        setNonBlocking(listen_);
+        frame_.reserve(max_cells);
+        work_.reserve(max_cells);
+        thread_ = std::thread([this] { run(); });
+        return true;
+    }
+
+    void stop() {
+        if (!thread_.joinable()) return;
+        stop_ = true;
+        thread_.join();
+        for (auto& c : clients_) closeSocket(c.s);
+        clients_.clear();
+        closeSocket(listen_);
+    }
+
+    // Main thread, after each published generation of the mirrored universe.
+    void offer(const std::vector<uint8_t>& cur, int w, int h, uint64_t generation, Neighborhood nb, int max_age,
+               uint64_t hash, bool hashed) {
+        if (viewers_.load(std::memory_order_relaxed) == 0) return;
+        std::lock_guard<std::mutex> lk(m_);
+        if (has_frame_) {
+            ++skipped_;
+            return;
+        }
+        frame_.assign(cur.begin(), cur.begin() + (size_t)w * h);
+        meta_ = Meta{w, h, generation, nb, max_age, hash, hashed};
+        has_frame_ = true;
+    }
+
+    // Buffers of both threads, for the memory ledger.
+    uint64_t bytes() const { return bytes_.load(std::memory_order_relaxed); }
+
+    // After stop().
+    void report(std::ostream& os) const {
+        os << "serve: " << connections_ << " viewers, " << keyframes_ << " keyframes, " << deltas_ << " deltas ("
+           << std::fixed << std::setprecision(1) << (deltas_ ? (double)delta_bytes_ / (double)deltas_ : 0.0)
+           << " bytes each), " << std::setprecision(2) << (double)bytes_sent_ / (1024.0 * 1024.0) << " MiB sent, "
+           << resyncs_ << " slow-viewer resyncs, " << skipped_ << " generations skipped\n";
+    }
+
+private:
+    struct Meta {
+        int w = 0, h = 0;
+        uint64_t generation = 0;
+        Neighborhood nb = Neighborhood::Moore;
+        int max_age = 0;
+        uint64_t hash = 0;
+        bool hashed = false;
+    };
+    struct Client {
+        SocketHandle s = kNoSocket;
+        std::vector<uint8_t> out;
+        size_t sent = 0;
+        bool needs_keyframe = true, closed = false;
+        size_t backlog() const { return out.size() - sent; }
+    };
+
+    void run() {
+        std::vector<pollfd> fds;
+        uint8_t scratch[512];
+        std::chrono::steady_clock::time_point drain_until{};
+        for (;;) {
+            // On stop, give the viewers up to a second to receive what is queued for them.
+            if (stop_) {
+                auto now = std::chrono::steady_clock::now();
+                if (drain_until == std::chrono::steady_clock::time_point{}) drain_until = now + std::chrono::seconds(1);
+                bool queued = false;
+                for (const auto& c : clients_) queued = queued || (c.backlog() && !c.closed);
+                if (!queued || now >= drain_until) break;
+            }
+            fds.clear();
+            fds.push_back(pollfd{listen_, POLLIN, 0});
+            for (const auto& c : clients_) fds.push_back(pollfd{c.s, (short)(POLLIN | (c.backlog() ? POLLOUT : 0)), 0});
+            pollSockets(fds.data(), fds.size(), 5);
+
+            if (fds[0].revents & POLLIN) {
+                for (SocketHandle s; (s = accept(listen_, nullptr, nullptr)) != kNoSocket;) {
+                    setNonBlocking(s);
+                    int one = 1;
+                    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+                    Client c;
+                    c.s = s;
+                    c.out = {'C', 'W', 'D', 'S', kStreamVersion};
+                    clients_.push_back(std::move(c));
+                    ++connections_;
+                }
+            }
+            // Viewers send nothing; a readable socket means it closed (or misbehaves).
+            for (size_t i = 0; i + 1 < fds.size(); ++i) {
+                if (!(fds[i + 1].revents & (POLLIN | POLLERR | POLLHUP))) continue;
+                int r = (int)recv(clients_[i].s, (char*)scratch, sizeof(scratch), 0);
+                if (r == 0 || (r < 0 && !socketWouldBlock())) clients_[i].closed = true;
+            }
+
+            bool got = false;
+            Meta meta;
+            {
+                std::lock_guard<std::mutex> lk(m_);
+                if (has_frame_) {
+                    work_.swap(frame_);
+                    meta = meta_;
+                    has_frame_ = false;
+                    got = true;
+                }
+                size_t held = frame_.capacity() + work_.capacity() + base_.capacity() + body_.capacity() + msg_.capacity();
+                for (const auto& c : clients_) held += c.out.capacity();
+                bytes_.store(held, std::memory_order_relaxed);
+            }
+            if (got) broadcast(meta);
+
+            for (auto& c : clients_) {
+                while (!c.closed && c.backlog()) {
+                    int r = (int)send(c.s, (const char*)c.out.data() + c.sent, (int)std::min<size_t>(c.backlog(), 1 << 20),
+                                      kSendFlags);
+                    if (r > 0) {
+                        c.sent += (size_t)r;
+                        bytes_sent_ += (uint64_t)r;
+                    } else {
+                        if (r < 0 && !socketWouldBlock()) c.closed = true;
+                        break;
+                    }
+                }
+                if (!c.backlog()) {
+                    c.out.clear();
+                    c.sent = 0;
+                }
+            }
+            for (size_t i = clients_.size(); i-- > 0;) {
+                if (!clients_[i].closed) continue;
+                closeSocket(clients_[i].s);
+                clients_.erase(clients_.begin() + (std::ptrdiff_t)i);
+            }
+            viewers_.store(clients_.size(), std::memory_order_relaxed);
+        }
+    }
+
+    void broadcast(const Meta& m) {
+        size_t cells = (size_t)m.w * m.h;
+        bool resized = m.w != base_w_ || m.h != base_h_;
+        bool any_synced = false;
+        for (auto& c : clients_) {
+            if (resized) c.needs_keyframe = true;
+            any_synced = any_synced || !c.needs_keyframe;
+        }
+        if (any_synced) {
+            // Advances the base to this frame as it goes.
+            body_.clear();
+            putVarint(body_, m.generation - base_generation_);
+            body_.push_back(m.hashed ? kStreamHashed : 0);
+            putLE(body_, m.hash, 8);
+            encodeRuns(cells);
+            frameMessage(kStreamDelta);
+            ++deltas_;
+            delta_bytes_ += msg_.size();
+            for (auto& c : clients_) {
+                if (c.needs_keyframe) continue;
+                if (c.backlog() + msg_.size() > kStreamQueueBytes) {
+                    c.needs_keyframe = true;
+                    ++resyncs_;
+                    continue;
+                }
+                c.out.insert(c.out.end(), msg_.begin(), msg_.end());
+            }
+        }
+        base_w_ = m.w;
+        base_h_ = m.h;
+        base_generation_ = m.generation;
+
+        bool encoded = false;
+        for (auto& c : clients_) {
+            if (!c.needs_keyframe || c.backlog()) continue;
+            if (!encoded) {
+                body_.clear();
+                putVarint(body_, (uint64_t)m.w);
+                putVarint(body_, (uint64_t)m.h);
+                putVarint(body_, m.generation);
+                body_.push_back((uint8_t)m.nb);
+                putVarint(body_, (uint64_t)m.max_age);
+                body_.push_back(m.hashed ? kStreamHashed : 0);
+                putLE(body_, m.hash, 8);
+                size_t at = body_.size();
+                body_.resize(at + packBitsBound(cells));
+                body_.resize(at + packBits(work_.data(), cells, body_.data() + at));
+                frameMessage(kStreamKeyframe);
+                ++keyframes_;
+                encoded = true;
+                if (!any_synced) {
+                    // Nobody took the delta, so the base is stale (it is only needed once someone is synced).
+                    base_.resize(cells);
+                    for (size_t i = 0; i < cells; ++i) base_[i] = work_[i] ? 0x80 : 0;
+                }
+            }
+            c.out.insert(c.out.end(), msg_.begin(), msg_.end());
+            c.needs_keyframe = false;
+        }
+    }
+
+    // Liveness XOR of work_ against base_ (0x80 per live cell, as nonZeroBytes() produces) as
+    // alternating run lengths; whole unchanged words are skipped eight cells at a time.
+    void encodeRuns(size_t cells) {
+        size_t run_start = 0;
+        bool flipping = false;
+        auto cell = [&](size_t i) {
+            uint8_t now = work_[i] ? 0x80 : 0;
+            if ((now != base_[i]) != flipping) {
+                putVarint(body_, i - run_start);
+                run_start = i;
+                flipping = !flipping;
+            }
+            base_[i] = now;
+        };
+        size_t i = 0;
+        for (; i + 8 <= cells; i += 8) {
+            uint64_t now = nonZeroBytes(load64(work_.data() + i));
+            if (!flipping && now == load64(base_.data() + i)) continue;
+            for (size_t k = 0; k < 8; ++k) cell(i + k);
+        }
+        for (; i < cells; ++i) cell(i);
+        if (flipping) putVarint(body_, cells - run_start);
+    }
+
+    void frameMessage(uint8_t kind) {
+        msg_.clear();
+        msg_.push_back(kind);
+        putVarint(msg_, body_.size());
+        msg_.insert(msg_.end(), body_.begin(), body_.end());
+    }
+
+    SocketHandle listen_ = kNoSocket;
+    std::thread thread_;
+    std::atomic<bool> stop_{false};
+    std::atomic<size_t> viewers_{0};
+    std::atomic<uint64_t> bytes_{0};
+
+    std::mutex m_;
+    std::vector<uint8_t> frame_; // offered by the main thread
+    Meta meta_;
+    bool has_frame_ = false;
+    uint64_t skipped_ = 0;
+
+    // Server thread.
+    std::vector<uint8_t> work_, base_, body_, msg_;
+    int base_w_ = 0, base_h_ = 0;
+    uint64_t base_generation_ = 0;
+    std::vector<Client> clients_;
+    uint64_t connections_ = 0, keyframes_ = 0, deltas_ = 0, delta_bytes_ = 0, bytes_sent_ = 0, resyncs_ = 0;
+};
+
+// ---------------- Worker pool ----------------
+//
+// A fixed set of threads serving lanes (one per universe). A lane holds at most one job, split into
+// chunks; idle threads take the next chunk round-robin across lanes, so a universe with a long step
+// shares the threads with the others instead of holding them until it is done. Whoever completes a
+// job's last chunk runs its finish function. Jobs are a function pointer and a context, so
+// submitting never allocates.
+class WorkerPool {
+public:
+    using ChunkFn = void (*)(void* ctx, int chunk);
+    using FinishFn = void (*)(void* ctx);
+
+    WorkerPool(int threads, int lanes) : lanes_((size_t)std::max(1, lanes)) {
+        for (int i = 0; i < threads; ++i) threads_.emplace_back([this] { run(); });
+    }
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            stop_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& t : threads_) t.join();
+    }
+
+    int threads() const { return (int)threads_.size(); }
+
+    // The lane must be idle. With rounds > 1 the chunks run that many times; `between` runs once all
+    // chunks of a round are done and before any chunk of the next one starts.
+    void submit(int lane, void* ctx, int chunks, ChunkFn fn, FinishFn finish, int rounds = 1,
+                FinishFn between = nullptr) {
+        {
+            std::lock_guard<std::mutex> lock(m_);
+            chunks = std::max(1, chunks);
+            lanes_[(size_t)lane] = Lane{ctx, fn, finish, between, chunks, 0, chunks, std::max(1, rounds), true};
+        }
+        work_cv_.notify_all();
+    }
+
+    // False once the lane's job has finished; the job's writes are then visible to the caller.
+    bool busy(int lane) {
+        std::lock_guard<std::mutex> lock(m_);
+        return lanes_[(size_t)lane].busy;
+    }
+
+    // Block until the lane's job is done, running its not-yet-started chunks on the calling thread.
+    void wait(int lane) {
+        std::unique_lock<std::mutex> lock(m_);
+        Lane& l = lanes_[(size_t)lane];
+        while (l.busy) {
+            if (l.next < l.chunks) runChunk(lock, l, l.next++);
+            else done_cv_.wait(lock);
+        }
+    }
+
+private:
+    struct Lane {
+        void* ctx = nullptr;
+        ChunkFn fn = nullptr;
+        FinishFn finish = nullptr;
+        FinishFn between = nullptr;
+        int chunks = 0, next = 0, remaining = 0, rounds = 1;
+        bool busy = false;
+    };
+
+    // Called and returns with the lock held; the chunk itself runs unlocked.
+    void runChunk(std::unique_lock<std::mutex>& lock, Lane& l, int chunk) {
+        lock.unlock();
+        l.fn(l.ctx, chunk);
+        lock.lock();
+        if (--l.remaining > 0) return;
+        if (--l.rounds > 0) {
+            lock.unlock();
+            if (l.between) l.between(l.ctx);
+            lock.lock();
+            l.next = 0;
+            l.remaining = l.chunks;
+            work_cv_.notify_all();
+            done_cv_.notify_all(); // waiters help with the next round
+            return;
+        }
+        lock.unlock();
+        if (l.finish) l.finish(l.ctx);
+        lock.lock();
+        l.busy = false;
+        done_cv_.notify_all();
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(m_);
+        for (;;) {
+            Lane* pick = nullptr;
+            for (size_t k = 0; k < lanes_.size() && !pick; ++k) {
+                size_t i = (rr_ + k) % lanes_.size();
+                if (lanes_[i].busy && lanes_[i].next < lanes_[i].chunks) {
+                    pick = &lanes_[i];
+                    rr_ = i + 1;
+                }
+            }
+            if (pick) {
+                runChunk(lock, *pick, pick->next++);
+                continue;
+            }
+            if (stop_) return;
+            work_cv_.wait(lock);
+        }
+    }
+
+    std::vector<Lane> lanes_;
+    size_t rr_ = 0;
+    bool stop_ = false;
+    std::mutex m_;
+    std::condition_variable work_cv_, done_cv_;
+    std::vector<std::thread> threads_;
+};
+
+// ---------------- Universes ----------------
+//
+// A universe is one simulated world with its own Config, grid and engine, drawn into a region of the
+// window. Normally there is one covering the whole window; --per-display gives each display its own.
+// From submitStep() until publishStep() the pool owns the grids, except that the rasteriser may keep
+// reading `cur` of a dense universe (its step only reads `cur` and writes `nxt`).
+
+struct PaintOp {
+    int32_t x, y;
+    bool alive;
+};
+
+struct Universe {
+    Config cfg;
+    SDL_Rect region{};  // window pixels
+    int grid_w = 0, grid_h = 0;
+    std::vector<uint8_t> cur, nxt;
+    std::vector<uint8_t> spare;        // dense steps of several generations ping-pong nxt <-> spare
+    uint64_t generation = 0;
+    uint64_t population = 0;           // written by the pool during a step
+    uint64_t published_population = 0; // main thread: population of the published generation
+    uint64_t noise_seed = 0;           // stochastic rules draw from (noise_seed, generation, cell)
+    TileGrid tiles;
+    GridHash hash;
+    RunEngine runs;
+    uint64_t runs_bytes = 0;           // runs.bytes() as of the last publish: a step reallocates the rows
+    LeniaEngine lenia;                 // --engine=lenia: the continuous state; `cur` holds it quantised
+    double lenia_error = 0.0;          // --verify: largest deviation from the direct convolution
+
+    bool in_flight = false;            // main thread: submitted, not yet published
+    std::vector<PaintOp> pending;      // painting while in flight, applied on publish
+    std::chrono::steady_clock::time_point last_step{};
+    LatencyHistogram step;             // submit to finish, including time queued behind other universes
+    uint64_t run_ns = 0;               // from the start of the run to the latest generation
+
+    // Written by the pool during a step.
+    int gens = 1;                      // generations the step advances
+    int round = 0;                     // generation within the step (dense), pool round (lenia)
+    std::chrono::steady_clock::time_point submitted{};
+    std::vector<uint64_t> band_population;
+    uint64_t step_ns = 0;
+    uint64_t tally_ns = 0;
+
+    // Drawing: `cur` is rasterised on the pool into `staging` (ARGB through the age palette, one
+    // pixel per cell, two for hex grids so odd rows can shift by half a cell), then uploaded into a
+    // streaming texture sized for the largest grid and scaled up by the GPU. Without a texture, cells
+    // are drawn as rectangles. Only frames after a step, paint, resize or palette change rasterise.
+    std::array<uint32_t, 256> palette{};
+    int palette_phase = -1;            // hue rotation the palette was built for (kPalettePhases per turn)
+    double cycle_turns = 0.0;          // colour cycling: hue rotation so far, in turns
+    std::chrono::steady_clock::time_point cycle_at{};
+    std::vector<uint32_t> staging;
+    int staging_w = 0;
+    SDL_Texture* texture = nullptr;
+    bool use_texture = true;           // false: the memory budget ruled the texture out
+    uint64_t texture_bytes = 0;
+    bool raster_dirty = true;          // `cur` or the palette changed since the last upload
+    bool rastering = false;            // rasterised this frame
+    std::chrono::steady_clock::time_point raster_submitted{};
+    uint64_t raster_ns = 0;
+    bool step_due = false;
+
+    // Step cost map (P, --cost-map): ns per tile of the latest step, written by the pool, and its
+    // exponentially decayed average per generation, updated on publish. Only collected while
+    // `profile` is set.
+    bool profile = false;
+    std::vector<uint64_t> tile_cost;
+    std::vector<float> cost_map;
+
+    // Activity map (--activity, A): updated by the pool during a step; restarts on resize.
+    bool track_activity = false;
+    std::vector<uint16_t> activity;
+    uint64_t activity_since = 0; // generation the map started at
+
+    // Object census (--census, O): counted on the pool after tiles changed, drawn as an overlay.
+    bool track_census = false;
+    ObjectCensus census;
+    bool censusing = false;            // counted this frame
+    std::chrono::steady_clock::time_point census_submitted{};
+    uint64_t census_ns = 0;
+    std::vector<SDL_Rect> text_rects;  // the overlay's glyph pixels
+
+    // --verify
+    std::vector<uint8_t> verify_in, verify_out;
+    TileGrid verify_tiles;
+    uint64_t verify_steps = 0, verify_failed_at = UINT64_MAX;
+};
+
+// Window regions for `count` universes: the given display bounds (window coordinates) when there
+// is one per universe, otherwise equal side-by-side columns.
+static void layoutRegions(std::vector<SDL_Rect>& out, int count, int win_w, int win_h,
+                          const std::vector<SDL_Rect>& displays) {
+    out.assign((size_t)count, SDL_Rect{0, 0, win_w, win_h});
+    if (count <= 1) return;
+    if ((int)displays.size() == count) {
+        out = displays;
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        int x0 = (int)((int64_t)win_w * i / count), x1 = (int)((int64_t)win_w * (i + 1) / count);
+        out[(size_t)i] = SDL_Rect{x0, 0, std::max(1, x1 - x0), win_h};
+    }
+}
+
+// Buffers, seeded soup (or library placements) and checkpoint restore for a region of w_px x h_px.
+// Touches no SDL state, so main() runs it on a worker thread while the window and renderer are
+// created. Returns the number of library patterns placed.
+static int seedUniverse(Universe& u, int w_px, int h_px, int reserve_w_px, int reserve_h_px, unsigned seed,
+                        const PatternLibrary* library) {
+    reserveGrid(u.cfg, reserve_w_px, reserve_h_px, u.cur, u.nxt);
+    u.grid_w = u.grid_h = 0;
+    u.cur.clear();
+    resizeGrid(u.cfg, w_px, h_px, u.grid_w, u.grid_h, u.cur, u.nxt);
+    std::mt19937 rng(seed);
+    u.noise_seed = seed;
+    int placed = 0;
+    if (library) {
+        int n = u.cfg.library_count > 0 ? u.cfg.library_count : std::max(1, u.grid_w * u.grid_h / 256);
+        placed = library->seed(u.cur, u.grid_w, u.grid_h, u.cfg.wrap, n, rng);
+        if (u.cfg.engine == Engine::Lenia) {
+            for (uint8_t& c : u.cur) c = c ? 255 : 0;
+        }
+    } else if (u.cfg.engine == Engine::Lenia) {
+        randomizeBlocks(u.cur, u.grid_w, u.grid_h, u.cfg.lenia_radius, u.cfg.density, rng);
+    } else {
+        randomize(u.cur, u.cfg.density, rng);
+    }
+
+    u.generation = 0;
+    if (u.cfg.checkpoint_file.empty()) return placed;
+    Checkpoint ck;
+    if (!loadCheckpoint(u.cfg.checkpoint_file, ck)) return placed;
+    std::fill(u.cur.begin(), u.cur.end(), 0);
+    for (int y = 0; y < std::min(ck.h, u.grid_h); ++y) {
+        std::copy_n(ck.ages.begin() + (size_t)y * ck.w, std::min(ck.w, u.grid_w), u.cur.begin() + idx(0, y, u.grid_w));
+    }
+    u.generation = ck.generation;
+    return 0;
+}
+
+// Sized for the largest grid the universe can get (the census is not told of resizes it has not reserved for).
+static void startCensus(Universe& u, int max_w, int max_h) {
+    u.census.reserve(max_w, max_h);
+    u.census.resize(u.grid_w, u.grid_h, u.cfg);
+    u.text_rects.reserve(kCensusTextRects);
+    u.track_census = true;
+}
+
+// Per-engine state sized for the largest region the universe can get.
+static void prepareUniverse(Universe& u, int reserve_w_px, int reserve_h_px) {
+    int cell = std::max(1, u.cfg.cell_px);
+    int max_w = std::max(1, reserve_w_px / cell), max_h = std::max(1, reserve_h_px / cell);
+    u.tiles.reserve(max_w, max_h);
+    u.hash.ages = u.cfg.hash_ages;
+    u.hash.reserve(u.tiles);
+    u.tiles.resize(u.grid_w, u.grid_h);
+    u.hash.update(u.cur, u.grid_w, u.grid_h, u.tiles);
+    u.tiles.clear();
+    u.band_population.reserve((size_t)std::max((max_h + kTileSize - 1) >> kTileShift, LeniaEngine::kChunks));
+    u.tile_cost.reserve(u.tiles.changed.capacity());
+    u.cost_map.reserve(u.tiles.changed.capacity());
+    u.tile_cost.assign(u.tiles.changed.size(), 0);
+    u.cost_map.assign(u.tiles.changed.size(), 0.0f);
+    u.pending.reserve(1024);
+    if (u.cfg.engine == Engine::Dense && u.cfg.gens_per_step > 1) u.spare.reserve(u.cur.capacity());
+    if (u.cfg.engine == Engine::Runs) {
+        u.runs.reserve(max_w, max_h);
+        u.runs.markAll(u.grid_w, u.grid_h);
+        u.runs_bytes = u.runs.bytes();
+    }
+    if (u.cfg.engine == Engine::Lenia) {
+        u.lenia.reserve(fftSize(max_w), fftSize(max_h), u.cfg);
+        u.lenia.configure(u.grid_w, u.grid_h, u.cfg);
+        u.lenia.load(u.cur);
+    }
+    if (u.cfg.activity) {
+        u.activity.reserve(u.cur.capacity());
+        u.activity.assign(u.cur.size(), 0);
+        u.activity_since = u.generation;
+        u.track_activity = true;
+    }
+    if (u.cfg.census) startCensus(u, max_w, max_h);
+    if (u.cfg.verify && u.cfg.engine != Engine::Lenia) {
+        u.verify_in.reserve(u.cur.capacity());
+        u.verify_out.reserve(u.cur.capacity());
+        u.verify_tiles.reserve(max_w, max_h);
+    }
+}
+
+// Only while no step is in flight.
+static void resizeUniverse(Universe& u, const SDL_Rect& region) {
+    u.region = region;
+    resizeGrid(u.cfg, region.w, region.h, u.grid_w, u.grid_h, u.cur, u.nxt);
+    if (u.cfg.engine == Engine::Runs) u.runs.markAll(u.grid_w, u.grid_h);
+    if (u.cfg.engine == Engine::Lenia) {
+        u.lenia.configure(u.grid_w, u.grid_h, u.cfg);
+        u.lenia.load(u.cur);
+    }
+    if (u.track_activity) {
+        u.activity.assign(u.cur.size(), 0);
+        u.activity_since = u.generation;
+    }
+    if (u.track_census) u.census.resize(u.grid_w, u.grid_h, u.cfg);
+    if (u.tiles.tiles_x != ((u.grid_w + kTileSize - 1) >> kTileShift) ||
+        u.tiles.tiles_y != ((u.grid_h + kTileSize - 1) >> kTileShift)) {
+        u.tiles.resize(u.grid_w, u.grid_h);
+        u.tile_cost.assign(u.tiles.changed.size(), 0);
+        u.cost_map.assign(u.tiles.changed.size(), 0.0f);
+    } else {
+        u.tiles.markAll();
+    }
+    u.raster_dirty = true;
+}
+
+// Window pixel -> cell of u (hex rows are drawn half a cell to the right on odd rows).
+static bool cellAt(const Universe& u, int px, int py, int& gx, int& gy) {
+    int cell = std::max(1, u.cfg.cell_px);
+    int mx = px - u.region.x, my = py - u.region.y;
+    if (mx < 0 || my < 0) return false;
+    gy = my / cell;
+    if (u.cfg.neighborhood == Neighborhood::Hex && (gy & 1)) mx -= cell / 2;
+    gx = mx >= 0 ? mx / cell : -1;
+    return gx >= 0 && gx < u.grid_w && gy >= 0 && gy < u.grid_h;
+}
+
+static void applyPaint(Universe& u, const PaintOp& p) {
+    if (u.cfg.engine == Engine::Lenia) {
+        size_t i = idx(p.x, p.y, u.grid_w);
+        u.cur[i] = p.alive ? 255 : 0;
+        u.lenia.set(i, u.cur[i]);
+    } else {
+        setCell(u.cur, u.grid_w, u.grid_h, p.x, p.y, p.alive);
+    }
+    u.raster_dirty = true;
+    u.tiles.mark(p.x, p.y);
+    if (u.cfg.engine == Engine::Runs) u.runs.markRow(p.y);
+    if (u.track_census) u.census.mark(p.x, p.y);
+}
+
+static void paintUniverse(Universe& u, int px, int py, bool alive) {
+    int gx = 0, gy = 0;
+    if (!cellAt(u, px, py, gx, gy)) return;
+    PaintOp p{gx, gy, alive};
+    if (!u.in_flight) applyPaint(u, p);
+    else if (u.pending.size() < u.pending.capacity()) u.pending.push_back(p);
+}
+
+static void stepChunk(void* ctx, int band) {
+    Universe& u = *static_cast<Universe*>(ctx);
+    const Config& c = u.cfg;
+    uint16_t* activity = u.track_activity ? u.activity.data() : nullptr;
+    if (c.engine == Engine::Runs) {
+        u.population = u.runs.advance(u.cur, u.grid_w, u.grid_h, u.gens, c.wrap, c.max_age, c.neighborhood, c.rule,
+                                      u.tiles, u.profile ? u.tile_cost.data() : nullptr, activity);
+        return;
+    }
+    if (c.engine == Engine::Lenia) {
+        int phase = u.round % LeniaEngine::kRounds;
+        uint64_t pop = u.lenia.run(phase, band, (float)c.lenia_dt, u.nxt, activity);
+        if (phase == LeniaEngine::kRounds - 1) u.band_population[(size_t)band] = pop;
+        return;
+    }
+    // Round 0 reads cur, so the rasteriser can keep reading it; later rounds alternate nxt and spare.
+    const std::vector<uint8_t>& src = u.round == 0 ? u.cur : (u.round & 1) ? u.nxt : u.spare;
+    std::vector<uint8_t>& dst = (u.round & 1) ? u.spare : u.nxt;
+    int y0 = band << kTileShift, y1 = std::min(u.grid_h, y0 + kTileSize);
+    uint64_t* cost = u.profile ? u.tile_cost.data() + (size_t)band * u.tiles.tiles_x : nullptr;
+    StepNoise noise;
+    if (isStochastic(c)) noise = stepNoise(c, u.noise_seed, u.generation + (uint64_t)u.round + 1);
+    u.band_population[(size_t)band] = stepLife(src, dst, u.grid_w, u.grid_h, y0, y1, c.wrap, c.max_age,
+                                               c.neighborhood, c.rule, u.tiles, cost, activity,
+                                               isStochastic(c) ? &noise : nullptr);
+}
+
+static void nextRound(void* ctx) {
+    ++static_cast<Universe*>(ctx)->round;
+}
+
+static void finishStep(void* ctx) {
+    Universe& u = *static_cast<Universe*>(ctx);
+    auto t0 = std::chrono::steady_clock::now();
+    if (u.cfg.engine != Engine::Runs) {
+        u.population = 0;
+        for (uint64_t p : u.band_population) u.population += p;
+    }
+    if (u.cfg.engine == Engine::Dense && (u.round & 1)) u.nxt.swap(u.spare);
+    if (u.cfg.engine == Engine::Lenia) u.tiles.markAll(); // every cell may move
+    u.hash.update(u.cfg.engine != Engine::Runs ? u.nxt : u.cur, u.grid_w, u.grid_h, u.tiles);
+    if (u.track_census) u.census.noteStep(u.tiles.changed);
+    u.tiles.clear();
+    auto t1 = std::chrono::steady_clock::now();
+    u.tally_ns = elapsedNs(t0, t1);
+    u.step_ns = elapsedNs(u.submitted, t1);
+}
+
+// Advances the universe `gens` generations; only the last one is published. Dense steps run as one
+// chunk per tile row, so they spread over the pool and interleave with other universes, with a
+// barrier between generations; the runs engine is sequential and runs as a single chunk. Lenia
+// generations are three rounds (row FFTs, column FFTs with the kernel product, inverse rows and growth)
+// of kChunks chunks each.
+static void submitStep(WorkerPool& pool, int lane, Universe& u, int gens = 1) {
+    if (u.cfg.verify) {
+        if (u.cfg.engine == Engine::Lenia) u.lenia.beginVerify();
+        else u.verify_in.assign(u.cur.begin(), u.cur.end());
+    }
+    if (u.profile) std::fill(u.tile_cost.begin(), u.tile_cost.end(), 0);
+    u.gens = std::max(1, gens);
+    u.round = 0;
+    int chunks = 1, rounds = 1;
+    if (u.cfg.engine == Engine::Dense) {
+        chunks = u.tiles.tiles_y;
+        rounds = u.gens;
+        u.band_population.assign((size_t)chunks, 0);
+        if (rounds > 1) u.spare.resize(u.cur.size());
+    } else if (u.cfg.engine == Engine::Lenia) {
+        chunks = LeniaEngine::kChunks;
+        rounds = u.gens * LeniaEngine::kRounds;
+        u.band_population.assign((size_t)chunks, 0);
+    }
+    u.submitted = std::chrono::steady_clock::now();
+    u.in_flight = true;
+    pool.submit(lane, &u, chunks, stepChunk, finishStep, rounds, nextRound);
+}
+
+// Main thread, after the pool finished the lane: make the new generation current.
+static void publishStep(Universe& u) {
+    if (u.cfg.engine != Engine::Runs) u.cur.swap(u.nxt);
+    u.generation += (uint64_t)u.gens;
+    u.raster_dirty = true;
+    u.in_flight = false;
+    u.published_population = u.population;
+    u.runs_bytes = u.runs.bytes();
+    if (u.track_census) u.census.publish();
+    u.step.record(u.step_ns);
+    if (u.profile) {
+        constexpr float kCostDecay = 1.0f / 16.0f; // weight of the newest step
+        for (size_t i = 0; i < u.cost_map.size(); ++i) {
+            u.cost_map[i] += ((float)u.tile_cost[i] / (float)u.gens - u.cost_map[i]) * kCostDecay;
+        }
+    }
+    if (u.cfg.verify && u.cfg.engine == Engine::Lenia) {
+        u.lenia_error = std::max(u.lenia_error, u.lenia.verify(u.gens, u.cfg.lenia_dt));
+        u.verify_steps += (uint64_t)u.gens;
+        if (u.lenia_error > kLeniaTolerance && u.verify_failed_at == UINT64_MAX) u.verify_failed_at = u.generation;
+    } else if (u.cfg.verify) {
+        for (int g = 0; g < u.gens; ++g) {
+            if (g) u.verify_in.swap(u.verify_out);
+            u.verify_tiles = u.tiles;
+            u.verify_out.assign(u.verify_in.size(), 0);
+            StepNoise noise = stepNoise(u.cfg, u.noise_seed, u.generation - (uint64_t)(u.gens - g) + 1);
+            stepLifeReference(u.verify_in, u.verify_out, u.grid_w, u.grid_h, u.cfg.wrap, u.cfg.max_age,
+                              u.cfg.neighborhood, u.cfg.rule, u.verify_tiles, isStochastic(u.cfg) ? &noise : nullptr);
+        }
+        u.verify_steps += (uint64_t)u.gens;
+        if (u.verify_out != u.cur && u.verify_failed_at == UINT64_MAX) u.verify_failed_at = u.generation;
+    }
+    for (const PaintOp& p : u.pending) applyPaint(u, p);
+    u.pending.clear();
+}
+
+// Hex rows are offset by half a cell, which the two-pixels-per-cell staging layout can only scale
+// exactly when the cell size is even; odd hex cells keep the rectangle drawing.
+static bool wantsTexture(const Universe& u) {
+    return u.use_texture && !(u.cfg.neighborhood == Neighborhood::Hex && (u.cfg.cell_px & 1));
+}
+
+static int stagingWidth(const Universe& u) {
+    return u.cfg.neighborhood == Neighborhood::Hex ? 2 * u.grid_w + 1 : u.grid_w;
+}
+
+// Colour cycling (--color-cycle, C) rotates the hue of the 256-entry age palette, never the pixels:
+// the rotation is quantised to kPalettePhases steps per turn, and only a new step rebuilds the
+// palette and marks the universe for a raster. Between steps and phase changes a frame re-presents
+// the uploaded texture, so the animation costs O(palette) per frame plus one LUT pass per phase.
+static constexpr int kPalettePhases = 360;
+
+static float paletteHue(const Universe& u) { return 360.0f * (float)std::max(0, u.palette_phase) / kPalettePhases; }
+
+static void setPalettePhase(Universe& u, int phase) {
+    if (phase == u.palette_phase) return;
+    u.palette_phase = phase;
+    const float hue = paletteHue(u);
+    for (int a = 0; a < 256; ++a) {
+        SDL_Color c = cellColor(u.cfg, (uint8_t)a, hue);
+        u.palette[(size_t)a] = 0xFF000000u | ((uint32_t)c.r << 16) | ((uint32_t)c.g << 8) | c.b;
+    }
+    u.raster_dirty = true;
+}
+
+// Main thread, once per frame: advances the rotation by the time since the previous frame.
+static void advancePalette(Universe& u, std::chrono::steady_clock::time_point now) {
+    if (u.cfg.color_cycle_s > 0 && u.cycle_at != std::chrono::steady_clock::time_point{}) {
+        double dt = std::chrono::duration<double>(now - u.cycle_at).count();
+        u.cycle_turns = std::fmod(u.cycle_turns + dt / u.cfg.color_cycle_s, 1.0);
+    }
+    u.cycle_at = now;
+    setPalettePhase(u, (int)(u.cycle_turns * kPalettePhases) % kPalettePhases);
+}
+
+// Streaming texture and staging buffer for the largest grid the universe can get, so resizes only
+// change the part in use. Leaves `texture` null (rectangle drawing) if the renderer refuses it.
+static void createUniverseTexture(SDL_Renderer* ren, Universe& u, int reserve_w_px, int reserve_h_px) {
+    int phase = std::max(0, u.palette_phase);
+    u.palette_phase = -1;
+    setPalettePhase(u, phase);
+    int cell = std::max(1, u.cfg.cell_px);
+    int max_w = std::max({1, reserve_w_px / cell, u.grid_w}), max_h = std::max({1, reserve_h_px / cell, u.grid_h});
+    int tex_w = u.cfg.neighborhood == Neighborhood::Hex ? 2 * max_w + 1 : max_w;
+    if (!wantsTexture(u)) return;
+    u.texture = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, tex_w, max_h);
+    if (!u.texture) return;
+    u.texture_bytes = (uint64_t)tex_w * max_h * sizeof(uint32_t);
+    u.staging.reserve((size_t)tex_w * max_h);
+}
+
+// One tile row of `cur` into the staging buffer.
+static void rasterChunk(void* ctx, int band) {
+    Universe& u = *static_cast<Universe*>(ctx);
+    const uint32_t* lut = u.palette.data();
+    const bool hex = u.cfg.neighborhood == Neighborhood::Hex;
+    int y0 = band << kTileShift, y1 = std::min(u.grid_h, y0 + kTileSize);
+    for (int y = y0; y < y1; ++y) {
+        const uint8_t* row = u.cur.data() + (size_t)y * u.grid_w;
+        uint32_t* out = u.staging.data() + (size_t)y * u.staging_w;
+        if (!hex) {
+            for (int x = 0; x < u.grid_w; ++x) out[x] = lut[row[x]];
+            continue;
+        }
+        int shift = y & 1;
+        out[0] = out[u.staging_w - 1] = lut[0];
+        for (int x = 0; x < u.grid_w; ++x) out[2 * x + shift] = out[2 * x + shift + 1] = lut[row[x]];
+    }
+}
+
+static void finishRaster(void* ctx) {
+    Universe& u = *static_cast<Universe*>(ctx);
+    u.raster_ns = elapsedNs(u.raster_submitted, std::chrono::steady_clock::now());
+}
+
+// The pool must not be writing `cur` (dense steps may be in flight; runs steps may not).
+static void submitRaster(WorkerPool& pool, int lane, Universe& u) {
+    u.staging_w = stagingWidth(u);
+    u.staging.resize((size_t)u.staging_w * u.grid_h);
+    u.raster_submitted = std::chrono::steady_clock::now();
+    pool.submit(lane, &u, u.tiles.tiles_y, rasterChunk, finishRaster);
+}
+
+static void censusChunk(void* ctx, int band) {
+    Universe& u = *static_cast<Universe*>(ctx);
+    u.census.run(u.cur, band);
+}
+
+static void nextCensusRound(void* ctx) {
+    static_cast<Universe*>(ctx)->census.nextRound();
+}
+
+static void finishCensus(void* ctx) {
+    Universe& u = *static_cast<Universe*>(ctx);
+    u.census.finish(u.cur);
+    u.census_ns = elapsedNs(u.census_submitted, std::chrono::steady_clock::now());
+}
+
+// Same constraint as submitRaster: the census reads `cur`. Two rounds of a chunk per tile row
+// (labelling, then the pairs across tile edges) and a sequential merge.
+static void submitCensus(WorkerPool& pool, int lane, Universe& u) {
+    u.census.begin();
+    u.census_submitted = std::chrono::steady_clock::now();
+    pool.submit(lane, &u, u.census.rows(), censusChunk, finishCensus, 2, nextCensusRound);
+}
+
+static void uploadUniverse(Universe& u) {
+    SDL_Rect src{0, 0, u.staging_w, u.grid_h};
+    SDL_UpdateTexture(u.texture, &src, u.staging.data(), u.staging_w * (int)sizeof(uint32_t));
+    u.raster_dirty = false;
+}
+
+// The reference drawing: one rectangle per live cell. --render-check compares the texture path
+// against it pixel for pixel.
+static void renderUniverseRects(SDL_Renderer* ren, const Universe& u) {
+    const int cell = u.cfg.cell_px;
+    SDL_Rect r{0, 0, cell, cell};
+    const int hex_shift = (u.cfg.neighborhood == Neighborhood::Hex) ? cell / 2 : 0;
+    for (int y = 0; y < u.grid_h; ++y) {
+        for (int x = 0; x < u.grid_w; ++x) {
+            uint8_t age = u.cur[idx(x, y, u.grid_w)];
+            if (!age) continue;
+
+            SDL_Color c = cellColor(u.cfg, age, paletteHue(u));
+            SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, 255);
+
+            r.x = u.region.x + x * cell + ((y & 1) ? hex_shift : 0);
+            r.y = u.region.y + y * cell;
+            SDL_RenderFillRect(ren, &r);
+        }
+    }
+}
+
+static void renderUniverse(SDL_Renderer* ren, const Universe& u) {
+    if (!u.texture) {
+        renderUniverseRects(ren, u);
+        return;
+    }
+    const int cell = u.cfg.cell_px;
+    SDL_Rect src{0, 0, u.staging_w, u.grid_h};
+    SDL_Rect dst{u.region.x, u.region.y, u.grid_w * cell, u.grid_h * cell};
+    if (u.cfg.neighborhood == Neighborhood::Hex) dst.w += cell / 2;
+    SDL_RenderCopy(ren, u.texture, &src, &dst);
+}
+
+// Translucent heat over each tile, blue (cheapest) to red (costliest tile of this universe).
+static void renderCostMap(SDL_Renderer* ren, const Universe& u) {
+    float peak = 0.0f;
+    for (float v : u.cost_map) peak = std::max(peak, v);
+    if (peak <= 0.0f) return;
+    const int tile_px = kTileSize * u.cfg.cell_px;
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+    for (int ty = 0; ty < u.tiles.tiles_y; ++ty) {
+        for (int tx = 0; tx < u.tiles.tiles_x; ++tx) {
+            float t = u.cost_map[(size_t)ty * u.tiles.tiles_x + tx] / peak;
+            SDL_Color c = hsvToRgb(240.0f * (1.0f - t), 1.0f, 1.0f);
+            SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, (Uint8)(48 + 112 * t));
+            SDL_Rect r{u.region.x + tx * tile_px, u.region.y + ty * tile_px,
+                       std::min(tile_px, (u.grid_w - tx * kTileSize) * u.cfg.cell_px),
+                       std::min(tile_px, (u.grid_h - ty * kTileSize) * u.cfg.cell_px)};
+            SDL_RenderFillRect(ren, &r);
+        }
+    }
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+}
+
+// A 5x7 bitmap font for the overlays: the characters of kFontChars, seven rows each, bit 4 the
+// leftmost pixel. Other characters draw as spaces.
+static constexpr char kFontChars[] = " %(),-./0123456789:=abcdefghijklmnopqrstuvwxyz";
+static constexpr uint8_t kFont[][7] = {
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03}, // '%'
+    {0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02}, // '('
+    {0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08}, // ')'
+    {0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08}, // ','
+    {0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00}, // '-'
+    {0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C}, // '.'
+    {0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00}, // '/'
+    {0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E}, // '0'
+    {0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E}, // '1'
+    {0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F}, // '2'
+    {0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E}, // '3'
+    {0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02}, // '4'
+    {0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E}, // '5'
+    {0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E}, // '6'
+    {0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08}, // '7'
+    {0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E}, // '8'
+    {0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C}, // '9'
+    {0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00}, // ':'
+    {0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00}, // '='
+    {0x00, 0x00, 0x0E, 0x01, 0x0F, 0x11, 0x0F}, // 'a'
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1E}, // 'b'
+    {0x00, 0x00, 0x0E, 0x10, 0x10, 0x11, 0x0E}, // 'c'
+    {0x01, 0x01, 0x0D, 0x13, 0x11, 0x11, 0x0F}, // 'd'
+    {0x00, 0x00, 0x0E, 0x11, 0x1F, 0x10, 0x0E}, // 'e'
+    {0x06, 0x09, 0x08, 0x1C, 0x08, 0x08, 0x08}, // 'f'
+    {0x00, 0x0F, 0x11, 0x11, 0x0F, 0x01, 0x0E}, // 'g'
+    {0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11}, // 'h'
+    {0x04, 0x00, 0x0C, 0x04, 0x04, 0x04, 0x0E}, // 'i'
+    {0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0C}, // 'j'
+    {0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12}, // 'k'
+    {0x0C, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E}, // 'l'
+    {0x00, 0x00, 0x1A, 0x15, 0x15, 0x11, 0x11}, // 'm'
+    {0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11}, // 'n'
+    {0x00, 0x00, 0x0E, 0x11, 0x11, 0x11, 0x0E}, // 'o'
+    {0x00, 0x00, 0x1E, 0x11, 0x1E, 0x10, 0x10}, // 'p'
+    {0x00, 0x00, 0x0D, 0x13, 0x0F, 0x01, 0x01}, // 'q'
+    {0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10}, // 'r'
+    {0x00, 0x00, 0x0E, 0x10, 0x0E, 0x01, 0x1E}, // 's'
+    {0x08, 0x08, 0x1C, 0x08, 0x08, 0x09, 0x06}, // 't'
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0D}, // 'u'
+    {0x00, 0x00, 0x11, 0x11, 0x11, 0x0A, 0x04}, // 'v'
+    {0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0A}, // 'w'
+    {0x00, 0x00, 0x11, 0x0A, 0x04, 0x0A, 0x11}, // 'x'
+    {0x00, 0x00, 0x11, 0x11, 0x0F, 0x01, 0x0E}, // 'y'
+    {0x00, 0x00, 0x1F, 0x02, 0x04, 0x08, 0x1F}, // 'z'
+};
+static_assert(std::size(kFont) == sizeof(kFontChars) - 1, "a glyph per font character");
+
+// Glyph pixels of `text` at (x, y), kScale window pixels each, appended to `out` up to its capacity.
+static void layoutText(std::vector<SDL_Rect>& out, const char* text, int x, int y, int scale) {
+    for (; *text; ++text, x += 6 * scale) {
+        const char* at = std::strchr(kFontChars, *text);
+        if (!at) continue;
+        const uint8_t* glyph = kFont[at - kFontChars];
+        for (int row = 0; row < 7; ++row) {
+            for (int col = 0; col < 5; ++col) {
+                if (!(glyph[row] >> (4 - col) & 1)) continue;
+                if (out.size() == out.capacity()) return;
+                out.push_back(SDL_Rect{x + col * scale, y + row * scale, scale, scale});
+            }
+        }
+    }
+}
+
+// The census in the region's top-left corner: the object count, then each kind with its named
+// objects, on a translucent panel. Lines are cut at the region's width.
+static void renderCensus(SDL_Renderer* ren, Universe& u) {
+    constexpr int kScale = 2, kAdvance = 6 * kScale, kLine = 9 * kScale, kMargin = 4 * kScale;
+    constexpr size_t kLen = 256;
+    const ObjectCensus& c = u.census;
+    const int max_chars = std::min<int>(kLen - 1, (u.region.w - 2 * kMargin) / kAdvance);
+    if (max_chars <= 0) return;
+    char lines[2 + kObjectKinds][kLen];
+    int n = 0;
+    auto append = [](char* line, const char* fmt, auto... args) {
+        size_t len = std::strlen(line);
+        if (len < kLen - 1) std::snprintf(line + len, kLen - len, fmt, args...);
+    };
+    lines[n][0] = '\0';
+    append(lines[n++], "%s %llu", "objects", (unsigned long long)c.objects);
+    if (c.named) {
+        for (int k = 0; k < kObjectKinds; ++k) {
+            char* line = lines[n++];
+            line[0] = '\0';
+            append(line, "%s %llu", objectKindName((ObjectKind)k), (unsigned long long)c.by_kind[(size_t)k]);
+            const char* sep = ": ";
+            for (int i = 0; i < kKnownObjectCount; ++i) {
+                if ((int)kKnownObjects[i].kind != k || !c.by_name[(size_t)i]) continue;
+                append(line, "%s%s %llu", sep, kKnownObjects[i].name, (unsigned long long)c.by_name[(size_t)i]);
+                sep = ", ";
+            }
+        }
+        lines[n][0] = '\0';
+        append(lines[n++], "%s %llu", "other", (unsigned long long)c.unnamed);
+    }
+
+    int widest = 0;
+    u.text_rects.clear();
+    for (int i = 0; i < n; ++i) {
+        lines[i][max_chars] = '\0';
+        widest = std::max(widest, (int)std::strlen(lines[i]));
+        layoutText(u.text_rects, lines[i], u.region.x + kMargin, u.region.y + kMargin + i * kLine, kScale);
+    }
+    SDL_Rect panel{u.region.x, u.region.y, std::min(u.region.w, widest * kAdvance + 2 * kMargin),
+                   std::min(u.region.h, n * kLine - 2 * kScale + 2 * kMargin)};
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 160);
+    SDL_RenderFillRect(ren, &panel);
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+    SDL_SetRenderDrawColor(ren, 255, 255, 255, 255);
+    SDL_RenderFillRects(ren, u.text_rects.data(), (int)u.text_rects.size());
+}
+
+static void printCostMapReport(std::ostream& os, const std::vector<std::unique_ptr<Universe>>& universes) {
+    for (size_t i = 0; i < universes.size(); ++i) {
+        const Universe& u = *universes[i];
+        if (!u.profile || u.cost_map.empty()) continue;
+        size_t hot = 0;
+        double sum = 0.0;
+        for (size_t k = 0; k < u.cost_map.size(); ++k) {
+            sum += u.cost_map[k];
+            if (u.cost_map[k] > u.cost_map[hot]) hot = k;
+        }
+        os << "cost map" << (universes.size() > 1 ? " universe " + std::to_string(i) : std::string()) << ": "
+           << u.tiles.tiles_x << "x" << u.tiles.tiles_y << " tiles, mean " << std::fixed << std::setprecision(2)
+           << sum / (double)u.cost_map.size() / 1e3 << " us, hottest (" << hot % (size_t)u.tiles.tiles_x << ","
+           << hot / (size_t)u.tiles.tiles_x << ") " << u.cost_map[hot] / 1e3 << " us per generation\n";
+    }
+    os.flush();
+}
+
+static void printCensusReport(std::ostream& os, const std::vector<std::unique_ptr<Universe>>& universes) {
+    for (size_t i = 0; i < universes.size(); ++i) {
+        const Universe& u = *universes[i];
+        if (!u.track_census) continue;
+        const ObjectCensus& c = u.census;
+        os << "census" << (universes.size() > 1 ? " universe " + std::to_string(i) : std::string()) << ": "
+           << c.objects << " objects (";
+        if (c.named) {
+            for (int k = 0; k < kObjectKinds; ++k) os << objectKindName((ObjectKind)k) << " " << c.by_kind[(size_t)k] << ", ";
+            os << "other " << c.unnamed << "; ";
+        }
+        os << ruleLabel(u.cfg) << ", " << std::fixed << std::setprecision(2) << (double)u.census_ns / 1e6
+           << " ms)\n";
+        if (!c.named) continue;
+        bool any = false;
+        for (int j = 0; j < kKnownObjectCount; ++j) {
+            if (!c.by_name[(size_t)j]) continue;
+            os << (any ? ", " : "  ") << kKnownObjects[j].name << " " << c.by_name[(size_t)j];
+            any = true;
+        }
+        if (any) os << "\n";
+    }
+    os.flush();
+}
+
+static void printUniverseReport(std::ostream& os, const std::vector<std::unique_ptr<Universe>>& universes) {
+    if (universes.size() < 2) return;
+    for (size_t i = 0; i < universes.size(); ++i) {
+        const Universe& u = *universes[i];
+        double secs = (double)u.run_ns / 1e9;
+        os << "universe " << i << ": " << u.grid_w << "x" << u.grid_h << " cells (" << engineName(u.cfg.engine) << ", "
+           << ruleLabel(u.cfg) << "), " << u.generation << " generations, "
+           << std::fixed << std::setprecision(1) << (secs > 0 ? (double)u.generation / secs : 0.0) << " gen/s\n";
+        printHistogramLine(os, "  step", u.step, 0);
+    }
+    os.flush();
+}
+
+// ---------------- Render self-check ----------------
+//
+// --render-check draws every frame twice, through the texture path and through the per-cell
+// rectangles, reads both back and requires them to be identical. It runs on the software renderer
+// (deterministic, works with SDL_VIDEODRIVER=offscreen or dummy) so a mismatch is a bug in the
+// rasteriser or in the destination rectangle, not a driver quirk. Universes without a texture (hex
+// grids with an odd cell size, textures released by the memory budget) draw rectangles both times,
+// so their frames do not count: the report names them, and fails if no frame had a texture at all.
+
+struct RenderCheck {
+    std::vector<uint32_t> fast, reference; // ARGB8888 read-backs
+    std::vector<uint64_t> covered;         // per universe: frames drawn through its texture
+    uint64_t checked = 0;                  // frames the check ran on
+    uint64_t frames = 0;                   // of those, frames with at least one texture
+    uint64_t failed_at = UINT64_MAX;       // generation of the first mismatch
+    int x = 0, y = 0;                      // first differing pixel
+    uint32_t fast_px = 0, reference_px = 0;
+};
+
+// No step may be in flight. Leaves the back buffer dirty; the next frame clears it.
+static void checkRender(SDL_Renderer* ren, WorkerPool& pool, int raster_lane,
+                        const std::vector<std::unique_ptr<Universe>>& universes, uint64_t generation, RenderCheck& rc) {
+    int w = 0, h = 0;
+    if (SDL_GetRendererOutputSize(ren, &w, &h) != 0 || w <= 0 || h <= 0) return;
+    rc.fast.resize((size_t)w * h);
+    rc.reference.resize((size_t)w * h);
+    rc.covered.resize(universes.size());
+    ++rc.checked;
+
+    bool textured = false;
+    for (size_t i = 0; i < universes.size(); ++i) {
+        Universe& u = *universes[i];
+        if (!u.texture) continue;
+        submitRaster(pool, raster_lane + (int)i, u);
+        pool.wait(raster_lane + (int)i);
+        uploadUniverse(u);
+        ++rc.covered[i];
+        textured = true;
+    }
+    if (!textured) return;
+    auto draw = [&](bool reference, std::vector<uint32_t>& out) {
+        SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+        SDL_RenderClear(ren);
+        for (const auto& u : universes) reference ? renderUniverseRects(ren, *u) : renderUniverse(ren, *u);
+        SDL_RenderReadPixels(ren, nullptr, SDL_PIXELFORMAT_ARGB8888, out.data(), w * (int)sizeof(uint32_t));
+    };
+    draw(false, rc.fast);
+    draw(true, rc.reference);
+    ++rc.frames;
+    if (rc.failed_at != UINT64_MAX) return;
+    auto m = std::mismatch(rc.fast.begin(), rc.fast.end(), rc.reference.begin());
+    if (m.first == rc.fast.end()) return;
+    size_t at = (size_t)(m.first - rc.fast.begin());
+    rc.failed_at = generation;
+    rc.x = (int)(at % (size_t)w);
+    rc.y = (int)(at / (size_t)w);
+    rc.fast_px = *m.first & 0xFFFFFFu;
+    rc.reference_px = *m.second & 0xFFFFFFu;
+}
+
+// False if the check failed: a mismatch, or no frame drawn through a texture.
+static bool printRenderCheckReport(std::ostream& os, const RenderCheck& rc) {
+    bool ok = true;
+    if (rc.failed_at != UINT64_MAX) {
+        os << "render check: MISMATCH at generation " << rc.failed_at << ", pixel (" << rc.x << "," << rc.y
+           << "): texture path #" << std::hex << std::setfill('0') << std::setw(6) << rc.fast_px << ", rectangles #"
+           << std::setw(6) << rc.reference_px << std::dec << std::setfill(' ') << "\n";
+        ok = false;
+    } else if (rc.frames == 0) {
+        os << "render check: FAILED, the texture path was not exercised (" << rc.checked
+           << " frames, every universe drawn as rectangles)\n";
+        ok = false;
+    } else {
+        os << "render check: " << rc.frames << " frames match the rectangle reference\n";
+    }
+    for (size_t i = 0; i < rc.covered.size(); ++i) {
+        if (rc.frames == 0 || rc.covered[i] == rc.checked) continue;
+        os << "render check: universe " << i << " not checked";
+        if (rc.covered[i]) os << " in " << rc.checked - rc.covered[i] << " of " << rc.checked << " frames";
+        os << " (drawn as rectangles, no texture)\n";
+    }
+    os.flush();
+    return ok;
+}
+
+// ---------------- Memory budget ----------------
+//
+// --memory-budget caps the tracked subsystems (MemoryKind). Before anything is allocated, the
+// configuration is degraded until its estimate fits; at run time, growth past the budget (the runs
+// engine follows the pattern, a window can outgrow its reservation) releases the textures.
+
+// Main thread, also while steps are in flight.
+static void measureUniverse(const Universe& u, MemoryLedger& m) {
+    m[MemoryKind::Grids] += u.cur.capacity() + u.nxt.capacity() + u.spare.capacity();
+    m[MemoryKind::Tiles] += u.tiles.changed.capacity() + u.hash.tile_hash.capacity() * sizeof(uint64_t) +
+                            u.band_population.capacity() * sizeof(uint64_t) + u.pending.capacity() * sizeof(PaintOp);
+    m[MemoryKind::Runs] += u.runs_bytes;
+    m[MemoryKind::Lenia] += u.lenia.bytes();
+    m[MemoryKind::Staging] += u.staging.capacity() * sizeof(uint32_t);
+    m[MemoryKind::Textures] += u.texture_bytes;
+    m[MemoryKind::Activity] += u.activity.capacity() * sizeof(uint16_t);
+    m[MemoryKind::Census] += u.census.bytes() + u.text_rects.capacity() * sizeof(SDL_Rect);
+    m[MemoryKind::Verify] += u.verify_in.capacity() + u.verify_out.capacity() + u.verify_tiles.changed.capacity();
+}
+
+// What seeding, prepareUniverse and createUniverseTexture reserve for a universe whose region can
+// grow to reserve_w_px x reserve_h_px. The runs engine's rows grow with the pattern and are left out.
+static MemoryLedger estimateUniverse(const Universe& u, int reserve_w_px, int reserve_h_px, bool checkpoint) {
+    int cell = std::max(1, u.cfg.cell_px);
+    uint64_t w = (uint64_t)std::max(1, reserve_w_px / cell), h = (uint64_t)std::max(1, reserve_h_px / cell);
+    uint64_t cells = w * h;
+    uint64_t tiles_y = (h + kTileSize - 1) >> kTileShift, tiles = ((w + kTileSize - 1) >> kTileShift) * tiles_y;
+    uint64_t tex_w = u.cfg.neighborhood == Neighborhood::Hex ? 2 * w + 1 : w;
+
+    MemoryLedger m;
+    m[MemoryKind::Grids] = cells * (u.cfg.engine == Engine::Dense ? (u.cfg.gens_per_step > 1 ? 3 : 2)
+                                    : u.cfg.engine == Engine::Lenia ? 2 : 1);
+    m[MemoryKind::Tiles] = tiles * (1 + sizeof(uint64_t)) + tiles_y * sizeof(uint64_t) + 1024 * sizeof(PaintOp);
+    if (u.cfg.engine == Engine::Runs) m[MemoryKind::Runs] = (12 * w + 32) * sizeof(int32_t) + h;
+    if (u.cfg.engine == Engine::Lenia) m[MemoryKind::Lenia] = LeniaEngine::estimateBytes(w, h, u.cfg.verify);
+    if (wantsTexture(u)) m[MemoryKind::Staging] = m[MemoryKind::Textures] = tex_w * h * sizeof(uint32_t);
+    if (u.cfg.activity) m[MemoryKind::Activity] = cells * sizeof(uint16_t);
+    if (u.cfg.census) m[MemoryKind::Census] = ObjectCensus::estimateBytes(w, h) + kCensusTextRects * sizeof(SDL_Rect);
+    if (u.cfg.verify && u.cfg.engine != Engine::Lenia) m[MemoryKind::Verify] = 2 * cells + tiles;
+    if (checkpoint) m[MemoryKind::Checkpoint] = cells + 37 + packBitsBound(cells);
+    return m;
+}
+
+// Degrade until the estimate fits: drop --verify, then the textures (cells are drawn as
+// rectangles), then, if allowed, double the cell size of the universe that needs the most. False if
+// a single cell per region still does not fit.
+static bool fitMemoryBudget(std::vector<std::unique_ptr<Universe>>& universes, const std::vector<SDL_Rect>& reserve,
+                            bool checkpoint, uint64_t budget, bool may_coarsen) {
+    auto estimate = [&](size_t i) {
+        return estimateUniverse(*universes[i], reserve[i].w, reserve[i].h, checkpoint && i == 0).total();
+    };
+    auto total = [&] {
+        uint64_t t = 0;
+        for (size_t i = 0; i < universes.size(); ++i) t += estimate(i);
+        return t;
+    };
+    uint64_t wanted = total();
+    if (wanted <= budget) return true;
+
+    for (auto& u : universes) u->cfg.verify = false;
+    if (total() <= budget) {
+        std::cerr << "memory budget: --verify dropped\n";
+        return true;
+    }
+    for (auto& u : universes) u->use_texture = false;
+    if (total() <= budget) {
+        std::cerr << "memory budget: --verify and textures dropped, drawing cells as rectangles\n";
+        return true;
+    }
+    while (may_coarsen) {
+        size_t big = 0;
+        for (size_t i = 1; i < universes.size(); ++i) if (estimate(i) > estimate(big)) big = i;
+        Config& c = universes[big]->cfg;
+        if (c.cell_px >= std::max(reserve[big].w, reserve[big].h)) break;
+        c.cell_px = std::max(1, c.cell_px) * 2;
+        if (total() <= budget) {
+            std::cerr << "memory budget: needs " << std::fixed << std::setprecision(1) << mib(wanted) << " MiB, fits "
+                      << mib(budget) << " MiB with --verify and textures dropped and larger cells:";
+            for (size_t i = 0; i < universes.size(); ++i) std::cerr << " " << universes[i]->cfg.cell_px << " px";
+            std::cerr << "\n";
+            return true;
+        }
+    }
+    return false;
+}
+
+// Releases the textures and staging buffers (drawing falls back to rectangles). The raster lanes must
+// be idle. True if anything was released.
+static bool shedMemory(std::vector<std::unique_ptr<Universe>>& universes) {
+    bool released = false;
+    for (auto& u : universes) {
+        if (!u->texture) continue;
+        SDL_DestroyTexture(u->texture);
+        u->texture = nullptr;
+        u->texture_bytes = 0;
+        u->use_texture = false;
+        std::vector<uint32_t>().swap(u->staging);
+        released = true;
+    }
+    return released;
 }
 
 // ---- Virtual desktop bounds (span all monitors) ----
@@ -217,7 +5533,7 @@ static SDL_Rect getVirtualDesktopBounds() {
 
 // ---------------- Windows screen saver argument handling ----------------
 
-enum class SaverMode { Config, Run, Preview, WindowedPreview };
+enum class SaverMode { Config, Run, Preview, WindowedPreview, Benchmark, Replay, Viewer };
 
 static std::string lower(std::string s) {
     for (auto& ch : s) ch = (char)std::tolower((unsigned char)ch);
@@ -254,6 +5570,18 @@ static bool parseInt(const std::string& s, int& out) {
     }
 }
 
+static bool parseCount(const std::string& s, int& out) {
+    try {
+        size_t pos = 0;
+        long v = std::stol(s, &pos, 10);
+        if (pos == 0 || v < 1 || v > 1000000000L) return false;
+        out = (int)v;
+        return true;
+    } catch (...) {
+        return false;
+    }
+}
+
 static void parseWxH(const std::string& s, int& w, int& h) {
     // Accepts "800x600"
     auto x = s.find('x');
@@ -270,9 +5598,176 @@ struct SaverArgs {
     uintptr_t preview_parent_hwnd = 0;
     int window_w = 1280;
     int window_h = 720;
+    int bench_generations = 1000;
+    std::string replay_path;
+    std::string viewer_address;             // /v HOST:PORT
+    int universes = 0;                      // --per-display=N; 0 = one per display
+    bool per_display = false;
+    std::vector<std::string> display_options; // --displayK=...: option list for universe K
 };
 
-static SaverArgs parseSaverArgs(int argc, char** argv) {
+// "--name=value" options; everything else is a positional screen saver argument.
+static bool isOption(const char* a) { return a[0] == '-' && a[1] == '-'; }
+
+// Options that may differ between universes (globally, or per display via --displayK=...).
+// Returns false if `name` is not one of them.
+static constexpr int kMaxGensPerStep = 1024;
+
+static bool applyUniverseOption(const std::string& name, const std::string& value, Config& cfg) {
+    int n = 0;
+    if (name == "cell-px") {
+        if (parseInt(value, n)) cfg.cell_px = n;
+    } else if (name == "engine") {
+        std::string v = lower(value);
+        if (v == "dense") cfg.engine = Engine::Dense;
+        else if (v == "runs") cfg.engine = Engine::Runs;
+        else if (v == "lenia") cfg.engine = Engine::Lenia;
+        else std::cerr << "Unknown engine: " << value << "\n";
+    } else if (name == "neighborhood" || name == "neighbourhood") {
+        std::string v = lower(value);
+        if (v == "moore") cfg.neighborhood = Neighborhood::Moore;
+        else if (v == "vonneumann" || v == "von-neumann") cfg.neighborhood = Neighborhood::VonNeumann;
+        else if (v == "hex") cfg.neighborhood = Neighborhood::Hex;
+        else std::cerr << "Unknown neighborhood: " << value << "\n";
+    } else if (name == "rule") {
+        if (parseRule(value, cfg.rule)) cfg.rule_set = true;
+        else std::cerr << "Invalid rule: " << value << " (expected e.g. B3/S23)\n";
+    } else if (name == "density") {
+        try { cfg.density = std::clamp(std::stod(value), 0.0, 1.0); } catch (...) {}
+    } else if (name == "lenia-radius") {
+        if (parseCount(value, n)) cfg.lenia_radius = std::min(n, 256);
+    } else if (name == "lenia-mu" || name == "lenia-sigma" || name == "lenia-dt") {
+        double& v = name == "lenia-mu" ? cfg.lenia_mu : name == "lenia-sigma" ? cfg.lenia_sigma : cfg.lenia_dt;
+        try {
+            double d = std::stod(value);
+            if (d > 0.0 && d <= 1.0) v = d;
+            else std::cerr << "--" << name << " must be in (0, 1]\n";
+        } catch (...) {
+            std::cerr << "Invalid number: " << value << "\n";
+        }
+    } else if (name == "birth-p" || name == "survive-p" || name == "noise") {
+        double& p = name == "birth-p" ? cfg.birth_p : name == "survive-p" ? cfg.survive_p : cfg.noise;
+        try { p = std::clamp(std::stod(value), 0.0, 1.0); } catch (...) { std::cerr << "Invalid probability: " << value << "\n"; }
+    } else if (name == "wrap") {
+        cfg.wrap = (lower(value) != "off" && value != "0");
+    } else if (name == "gens-per-step") {
+        if (parseCount(value, n)) cfg.gens_per_step = std::min(n, kMaxGensPerStep);
+    } else if (name == "color-cycle" || name == "colour-cycle") {
+        if (value == "0" || lower(value) == "off") cfg.color_cycle_s = 0;
+        else if (parseCount(value, n)) cfg.color_cycle_s = n;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// "--display1=rule=B36/S23,cell-px=8" -> universe options for display 1.
+static void applyDisplayOptions(const std::string& list, Config& cfg) {
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t comma = list.find(',', pos);
+        std::string item = list.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        pos = (comma == std::string::npos) ? list.size() + 1 : comma + 1;
+        if (item.empty()) continue;
+        auto eq = item.find('=');
+        std::string name = lower(item.substr(0, eq));
+        std::string value = (eq == std::string::npos) ? std::string() : item.substr(eq + 1);
+        if (!applyUniverseOption(name, value, cfg)) std::cerr << "Not a per-display option: " << item << "\n";
+    }
+}
+
+static void parseOptions(int argc, char** argv, Config& cfg, SaverArgs& sargs) {
+    for (int i = 1; i < argc; ++i) {
+        if (!isOption(argv[i])) continue;
+        std::string a = argv[i] + 2;
+        auto eq = a.find('=');
+        std::string name = lower(a.substr(0, eq));
+        std::string value = (eq == std::string::npos) ? std::string() : a.substr(eq + 1);
+
+        int n = 0;
+        if (applyUniverseOption(name, value, cfg)) {
+            // handled
+        } else if (name == "verify") {
+            cfg.verify = true;
+        } else if (name == "per-display") {
+            sargs.per_display = true;
+            if (!value.empty() && parseInt(value, n)) sargs.universes = std::min(n, 16);
+        } else if (name.compare(0, 7, "display") == 0 && name.size() > 7 &&
+                   std::all_of(name.begin() + 7, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            int k = std::atoi(name.c_str() + 7);
+            if (k < 16) {
+                if ((int)sargs.display_options.size() <= k) sargs.display_options.resize((size_t)k + 1);
+                sargs.display_options[(size_t)k] = value;
+                sargs.per_display = true;
+            }
+        } else if (name == "window") {
+            parseWxH(lower(value), sargs.window_w, sargs.window_h);
+        } else if (name == "export-dir") {
+            cfg.export_dir = value;
+        } else if (name == "export") {
+            cfg.bench_export = value;
+        } else if (name == "metrics-file") {
+            cfg.metrics_file = value;
+        } else if (name == "metrics-interval") {
+            if (parseCount(value, n)) cfg.metrics_interval_ms = n;
+        } else if (name == "synthetic-input") {
+            cfg.synthetic_input = true;
+        } else if (name == "alloc-check") {
+            cfg.alloc_check = true;
+            cfg.synthetic_input = true;
+        } else if (name == "record") {
+            cfg.record_file = value;
+        } else if (name == "replay-speed") {
+            cfg.replay_max_speed = (lower(value) == "max");
+        } else if (name == "hash-ages") {
+            cfg.hash_ages = true;
+        } else if (name == "hash-log") {
+            cfg.hash_log_file = value;
+        } else if (name == "checkpoint") {
+            cfg.checkpoint_file = value;
+        } else if (name == "checkpoint-interval") {
+            if (parseCount(value, n)) cfg.checkpoint_interval_s = n;
+        } else if (name == "soak") {
+            if (parseCount(value, n)) cfg.soak_s = n;
+        } else if (name == "soak-interval") {
+            if (parseCount(value, n)) cfg.soak_interval_s = n;
+        } else if (name == "soak-csv") {
+            cfg.soak_csv = value;
+        } else if (name == "activity") {
+            cfg.activity = true;
+        } else if (name == "activity-export") {
+            cfg.activity_export = value;
+            cfg.activity = true;
+        } else if (name == "cost-map") {
+            cfg.cost_map = true;
+        } else if (name == "census") {
+            cfg.census = true;
+        } else if (name == "render-check") {
+            cfg.render_check = true;
+        } else if (name == "serve") {
+            cfg.serve = value;
+        } else if (name == "library") {
+            cfg.library = value;
+        } else if (name == "library-count") {
+            if (parseCount(value, n)) cfg.library_count = n;
+        } else if (name == "build-library") {
+            cfg.build_library = value;
+        } else if (name == "memory-budget") {
+            if (parseCount(value, n)) cfg.memory_budget_mb = n;
+        } else {
+            std::cerr << "Unknown option: " << argv[i] << "\n";
+        }
+    }
+}
+
+static SaverArgs parseSaverArgs(int argc_all, char** argv_all) {
+    std::vector<char*> pos;
+    for (int i = 0; i < argc_all; ++i) {
+        if (i == 0 || !isOption(argv_all[i])) pos.push_back(argv_all[i]);
+    }
+    int argc = (int)pos.size();
+    char** argv = pos.data();
+
     SaverArgs out;
     if (argc <= 1) { out.mode = SaverMode::Config; return out; }
 
@@ -313,10 +5808,264 @@ static SaverArgs parseSaverArgs(int argc, char** argv) {
         return out;
     }
 
+    if (startsWith(a1, "b")) {
+        out.mode = SaverMode::Benchmark;
+
+        //   /b:5000  or  /b 5000
+        auto colon = a1.find(':');
+        int n = 0;
+        if (colon != std::string::npos && colon + 1 < a1.size()) {
+            if (parseCount(a1.substr(colon + 1), n)) out.bench_generations = n;
+        } else if (argc >= 3) {
+            if (parseCount(argv[2], n)) out.bench_generations = n;
+        }
+        return out;
+    }
+
+    if (startsWith(a1, "r")) {
+        out.mode = SaverMode::Replay;
+
+        //   /r:PATH  or  /r PATH   (taken from the raw argument: paths are case-sensitive)
+        std::string raw = argv[1];
+        auto colon = raw.find(':');
+        if (colon != std::string::npos && colon + 1 < raw.size()) {
+            out.replay_path = raw.substr(colon + 1);
+        } else if (argc >= 3) {
+            out.replay_path = argv[2];
+        }
+        return out;
+    }
+
+    if (startsWith(a1, "v")) {
+        out.mode = SaverMode::Viewer;
+
+        //   /v:HOST:PORT  or  /v HOST:PORT
+        std::string raw = argv[1];
+        auto colon = raw.find(':');
+        if (colon != std::string::npos && colon + 1 < raw.size()) {
+            out.viewer_address = raw.substr(colon + 1);
+        } else if (argc >= 3) {
+            out.viewer_address = argv[2];
+        }
+        return out;
+    }
+
     out.mode = SaverMode::Run;
     return out;
 }
 
+// ---------------- Delta stream viewer (/v) ----------------
+
+// Mirrors a --serve stream in a window, scaled to fit. Exits when the server goes away; the exit code
+// is 1 if it never connected, the stream was malformed or a checksum did not match.
+static int runViewer(const SaverArgs& sargs, const Config& cfg) {
+    std::string host, err;
+    int port = 0;
+    if (!parseHostPort(sargs.viewer_address, host, port) || host.empty()) {
+        std::cerr << "/v needs HOST:PORT, got '" << sargs.viewer_address << "'\n";
+        return 1;
+    }
+    if (!initSockets()) {
+        std::cerr << "socket initialisation failed\n";
+        return 1;
+    }
+    // The server may still be starting.
+    SocketHandle sock = kNoSocket;
+    for (int attempt = 0; attempt < 50 && sock == kNoSocket; ++attempt) {
+        sock = openSocket(host, port, false, err);
+        if (sock == kNoSocket) SDL_Delay(200);
+    }
+    if (sock == kNoSocket) {
+        std::cerr << "Cannot connect to " << sargs.viewer_address << ": " << err << "\n";
+        return 1;
+    }
+    setNonBlocking(sock);
+
+    std::string title = "Conway viewer - " + sargs.viewer_address;
+    SDL_Window* window = SDL_CreateWindow(title.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
+                                          sargs.window_w, sargs.window_h, SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE);
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    SDL_Renderer* ren = window ? SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED) : nullptr;
+    if (window && !ren) ren = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
+    if (!ren) {
+        std::cerr << "Viewer window failed: " << SDL_GetError() << "\n";
+        if (window) SDL_DestroyWindow(window);
+        closeSocket(sock);
+        return 1;
+    }
+
+    Universe u;
+    u.cfg = cfg;
+    u.hash.ages = false;
+    WorkerPool pool(1, 1);
+    std::vector<uint8_t> in;
+    size_t in_at = 0;
+    bool handshake = false, malformed = false, dirty = true;
+    uint64_t keyframes = 0, deltas = 0, received = 0, hash_checks = 0, mismatch_at = UINT64_MAX;
+
+    // Largest whole cell size that fits the window, centred; the texture follows the cell size.
+    auto fit = [&] {
+        if (u.grid_w <= 0 || u.grid_h <= 0) return;
+        int ww = 0, wh = 0;
+        SDL_GetRendererOutputSize(ren, &ww, &wh);
+        const bool hex = u.cfg.neighborhood == Neighborhood::Hex;
+        int cell = std::max(1, std::min(ww / u.grid_w, wh / u.grid_h));
+        while (cell > 1 && u.grid_w * cell + (hex ? cell / 2 : 0) > ww) --cell;
+        u.cfg.cell_px = cell;
+        u.region = SDL_Rect{std::max(0, (ww - u.grid_w * cell) / 2), std::max(0, (wh - u.grid_h * cell) / 2),
+                            u.grid_w * cell, u.grid_h * cell};
+        if (u.texture) SDL_DestroyTexture(u.texture);
+        u.texture = nullptr;
+        createUniverseTexture(ren, u, u.region.w, u.region.h);
+        dirty = true;
+    };
+    auto checkHash = [&](uint8_t flags, uint64_t hash) {
+        u.hash.update(u.cur, u.grid_w, u.grid_h, u.tiles);
+        u.tiles.clear();
+        if (!(flags & kStreamHashed)) return;
+        ++hash_checks;
+        if (u.hash.value() != hash && mismatch_at == UINT64_MAX) mismatch_at = u.generation;
+    };
+    auto keyframe = [&](ByteReader& r) {
+        int w = (int)r.varint(), h = (int)r.varint();
+        uint64_t generation = r.varint();
+        uint8_t nb = r.byte();
+        int max_age = (int)r.varint();
+        uint8_t flags = r.byte();
+        uint64_t hash = r.u64le();
+        if (!r.ok || w <= 0 || h <= 0 || (uint64_t)w * (uint64_t)h > ((uint64_t)1 << 32) || nb > 2) return false;
+        u.cur.resize((size_t)w * h);
+        if (!unpackBits(r.p, (size_t)(r.end - r.p), u.cur.data(), u.cur.size())) return false;
+        bool resized = w != u.grid_w || h != u.grid_h || (Neighborhood)nb != u.cfg.neighborhood;
+        u.grid_w = w;
+        u.grid_h = h;
+        u.generation = generation;
+        u.cfg.neighborhood = (Neighborhood)nb;
+        u.cfg.max_age = max_age;
+        u.tiles.resize(w, h);
+        checkHash(flags, hash);
+        if (resized || !u.texture) fit();
+        ++keyframes;
+        return true;
+    };
+    // Ages advance like the engines' (nextAge), by the generations the delta spans.
+    auto delta = [&](ByteReader& r) {
+        if (u.grid_w <= 0) return false;
+        uint64_t gens = r.varint();
+        uint8_t flags = r.byte();
+        uint64_t hash = r.u64le();
+        if (!r.ok) return false;
+        const int cap = std::clamp(u.cfg.max_age, 1, 255), step = (int)std::min<uint64_t>(gens, 255);
+        for (uint8_t& a : u.cur) {
+            if (a) a = (uint8_t)std::min(cap, a + step);
+        }
+        size_t cells = u.cur.size(), at = 0;
+        for (bool flipping = false; r.p < r.end; flipping = !flipping) {
+            uint64_t n = r.varint();
+            if (!r.ok || n > cells - at) return false;
+            if (flipping) {
+                for (size_t i = at; i < at + n; ++i) {
+                    u.cur[i] = u.cur[i] ? 0 : 1;
+                    u.tiles.mark((int)(i % (size_t)u.grid_w), (int)(i / (size_t)u.grid_w));
+                }
+            }
+            at += n;
+        }
+        u.generation += gens;
+        checkHash(flags, hash);
+        ++deltas;
+        return true;
+    };
+
+    bool running = true;
+    while (running) {
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) {
+            if (e.type == SDL_QUIT) running = false;
+            if (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE) running = false;
+            if (e.type == SDL_WINDOWEVENT && e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED) fit();
+        }
+
+        uint8_t buf[1 << 16];
+        bool got = false;
+        for (;;) {
+            int r = (int)recv(sock, (char*)buf, sizeof(buf), 0);
+            if (r > 0) {
+                in.insert(in.end(), buf, buf + r);
+                received += (uint64_t)r;
+                got = true;
+                continue;
+            }
+            if (r == 0 || !socketWouldBlock()) running = false; // server gone
+            break;
+        }
+
+        if (!handshake && in.size() >= 5) {
+            if (std::memcmp(in.data(), "CWDS", 4) != 0 || in[4] != kStreamVersion) {
+                malformed = true;
+                break;
+            }
+            in_at = 5;
+            handshake = true;
+        }
+        while (handshake && in_at < in.size()) {
+            ByteReader r{in.data() + in_at, in.data() + in.size()};
+            uint8_t kind = r.byte();
+            uint64_t size = r.varint();
+            if (!r.ok || size > (uint64_t)(r.end - r.p)) break; // incomplete
+            ByteReader body{r.p, r.p + size};
+            bool ok = kind == kStreamKeyframe ? keyframe(body) : kind == kStreamDelta ? delta(body) : true;
+            if (!ok) {
+                malformed = true;
+                running = false;
+                break;
+            }
+            in_at = (size_t)(r.p + size - in.data());
+            dirty = true;
+        }
+        if (in_at == in.size()) {
+            in.clear();
+            in_at = 0;
+        } else if (in_at > in.size() / 2) {
+            in.erase(in.begin(), in.begin() + (std::ptrdiff_t)in_at);
+            in_at = 0;
+        }
+
+        advancePalette(u, std::chrono::steady_clock::now());
+        if ((dirty || u.raster_dirty) && u.grid_w > 0) {
+            if (u.texture) {
+                submitRaster(pool, 0, u);
+                pool.wait(0);
+                uploadUniverse(u);
+            }
+            SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+            SDL_RenderClear(ren);
+            renderUniverse(ren, u);
+            SDL_RenderPresent(ren);
+            dirty = u.raster_dirty = false;
+        }
+        if (!got) SDL_Delay(5);
+    }
+
+    closeSocket(sock);
+    if (u.texture) SDL_DestroyTexture(u.texture);
+    SDL_DestroyRenderer(ren);
+    SDL_DestroyWindow(window);
+
+    std::cout << "viewer: " << keyframes << " keyframes, " << deltas << " deltas, " << received << " bytes, generation "
+              << u.generation << "\n";
+    if (malformed) {
+        std::cout << "viewer: malformed stream\n";
+        return 1;
+    }
+    if (mismatch_at != UINT64_MAX) {
+        std::cout << "viewer: checksum MISMATCH at generation " << mismatch_at << "\n";
+        return 1;
+    }
+    std::cout << "viewer: " << hash_checks << " checksums match the server\n";
+    return keyframes ? 0 : 1;
+}
+
 #ifdef _WIN32
 static HWND createPreviewChild(HWND parent) {
     RECT rc{};
@@ -347,13 +6096,28 @@ static void makeWindowTopmost(SDL_Window* win, const SDL_Rect& r) {
 #endif
 
 int main(int argc, char** argv) {
+    StartupTimeline startup;
     Config cfg;
     SaverArgs sargs = parseSaverArgs(argc, argv);
+    parseOptions(argc, argv, cfg, sargs);
+
+    if (!cfg.build_library.empty()) {
+        std::vector<std::string> sources;
+        for (int i = 1; i < argc; ++i) if (!isOption(argv[i])) sources.emplace_back(argv[i]);
+        return buildLibrary(cfg.build_library, sources);
+    }
 
     if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         std::cerr << "SDL_Init failed: " << SDL_GetError() << "\n";
         return 1;
     }
+    startup.mark("sdl_init");
+
+    if (sargs.mode == SaverMode::Viewer) {
+        int rc = runViewer(sargs, cfg);
+        SDL_Quit();
+        return rc;
+    }
 
     if (sargs.mode == SaverMode::Config) {
         SDL_ShowSimpleMessageBox(
@@ -363,10 +6127,14 @@ int main(int argc, char** argv) {
             "Run modes:\n"
             "  /s  Fullscreen across all monitors\n"
             "  /p <HWND> Preview\n"
-            "  /c  Config (this dialog)\n\n"
+            "  /c  Config (this dialog)\n"
+            "  /b[:N] Headless benchmark for N generations\n"
+            "  /r <FILE> Headless replay of a --record log\n"
+            "  /v <HOST:PORT> View a universe served with --serve\n\n"
             "Controls:\n"
             "  Left mouse  = paint live cells\n"
             "  Right mouse = erase cells\n"
+            "  H           = print latency report\n"
             "  ESC         = exit\n",
             nullptr
         );
@@ -377,9 +6145,168 @@ int main(int argc, char** argv) {
     const bool isEmbeddedPreview = (sargs.mode == SaverMode::Preview);
     const bool isWindowedPreview = (sargs.mode == SaverMode::WindowedPreview);
     const bool isFullRun = (sargs.mode == SaverMode::Run);
+    const bool isBenchmark = (sargs.mode == SaverMode::Benchmark);
+    const bool isReplay = (sargs.mode == SaverMode::Replay);
+    const bool isHeadless = isBenchmark || isReplay;
+
+    InputLog replay;
+    if (isReplay) {
+        std::string err;
+        if (sargs.replay_path.empty() || !loadInputLog(sargs.replay_path, replay, err)) {
+            std::cerr << "Cannot replay '" << sargs.replay_path << "': " << err << "\n";
+            SDL_Quit();
+            return 1;
+        }
+        // The recorded simulation settings win; run-time options (metrics, speed) still apply.
+        cfg.cell_px = replay.cfg.cell_px;
+        cfg.ms_per_step = replay.cfg.ms_per_step;
+        cfg.density = replay.cfg.density;
+        cfg.wrap = replay.cfg.wrap;
+        cfg.max_age = replay.cfg.max_age;
+        cfg.neighborhood = replay.cfg.neighborhood;
+        cfg.rule = replay.cfg.rule;
+        cfg.rule_set = true;
+        cfg.birth_p = replay.cfg.birth_p;
+        cfg.survive_p = replay.cfg.survive_p;
+        cfg.noise = replay.cfg.noise;
+        // Dense and runs produce the same generations, so either may replay the other's log.
+        if (cfg.engine == Engine::Lenia || replay.cfg.engine == Engine::Lenia) cfg.engine = replay.cfg.engine;
+        cfg.lenia_radius = replay.cfg.lenia_radius;
+        cfg.lenia_mu = replay.cfg.lenia_mu;
+        cfg.lenia_sigma = replay.cfg.lenia_sigma;
+        cfg.lenia_dt = replay.cfg.lenia_dt;
+        cfg.record_file.clear();
+        sargs.window_w = replay.win_w;
+        sargs.window_h = replay.win_h;
+        sargs.per_display = false;
+    }
 
     SDL_Window* window = nullptr;
     SDL_Rect virtualBounds = getVirtualDesktopBounds();
+    startup.mark("displays");
+
+    // Benchmarks use a fixed seed so runs are comparable across builds; replays use the recorded one.
+    unsigned seed = isBenchmark ? 1u
+                  : isReplay    ? (unsigned)replay.seed
+                  : (unsigned)std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    // Benchmarks and replays must start from their seed, never from a saved universe.
+    if (isHeadless) cfg.checkpoint_file.clear();
+    if (isBenchmark) cfg.ms_per_step = 0;
+    if (isReplay && cfg.replay_max_speed) cfg.ms_per_step = 0;
+    if (!isBenchmark) cfg.verify = false;
+
+    // One universe for the whole window, or one per display (--per-display, --displayK=...). In the
+    // full-screen run each display gets its own bounds; elsewhere the window is split into columns.
+    int universe_count = 1;
+    if (sargs.per_display && !isEmbeddedPreview) {
+        universe_count = sargs.universes > 0 ? sargs.universes
+                       : std::max(SDL_GetNumVideoDisplays(), (int)sargs.display_options.size());
+        universe_count = std::clamp(universe_count, 1, 16);
+    }
+    std::vector<SDL_Rect> display_regions;
+    if (isFullRun && universe_count > 1 && universe_count == SDL_GetNumVideoDisplays()) {
+        for (int i = 0; i < universe_count; ++i) {
+            SDL_Rect b{};
+            if (SDL_GetDisplayBounds(i, &b) != 0) {
+                display_regions.clear();
+                break;
+            }
+            display_regions.push_back(SDL_Rect{b.x - virtualBounds.x, b.y - virtualBounds.y, b.w, b.h});
+        }
+    }
+    if (universe_count > 1 && (!cfg.record_file.empty() || !cfg.checkpoint_file.empty())) {
+        std::cerr << "--record and --checkpoint need a single universe; ignored with --per-display\n";
+        cfg.record_file.clear();
+        cfg.checkpoint_file.clear();
+    }
+    std::vector<std::unique_ptr<Universe>> universes;
+    for (int i = 0; i < universe_count; ++i) {
+        auto u = std::make_unique<Universe>();
+        u->cfg = cfg;
+        if ((size_t)i < sargs.display_options.size()) applyDisplayOptions(sargs.display_options[(size_t)i], u->cfg);
+        if (!u->cfg.rule_set) u->cfg.rule = defaultRule(u->cfg.neighborhood);
+        if (u->cfg.engine == Engine::Runs && isStochastic(u->cfg)) {
+            // Noise touches every cell, so there are no sparse runs to exploit.
+            std::cerr << "Stochastic rules need the dense engine; universe " << i << " uses it\n";
+            u->cfg.engine = Engine::Dense;
+        }
+        if (u->cfg.engine == Engine::Lenia && (!u->cfg.wrap || u->cfg.neighborhood != Neighborhood::Moore ||
+                                               isStochastic(u->cfg))) {
+            // The FFT convolution is circular, and the kernel replaces the neighbourhood and rule.
+            std::cerr << "Lenia runs on a square torus without rule noise; universe " << i << " uses one\n";
+            u->cfg.wrap = true;
+            u->cfg.neighborhood = Neighborhood::Moore;
+            u->cfg.birth_p = u->cfg.survive_p = 1.0;
+            u->cfg.noise = 0.0;
+        }
+        if (u->cfg.engine == Engine::Lenia && u->cfg.census) {
+            std::cerr << "The object census counts live cells, which Lenia does not have; universe " << i
+                      << " runs without it\n";
+            u->cfg.census = false;
+        }
+        universes.push_back(std::move(u));
+    }
+    Universe& primary = *universes[0];
+
+    // The library is mapped here and read by the seeding worker; a bad library falls back to soups.
+    PatternLibrary library;
+    const PatternLibrary* seed_library = nullptr;
+    if (!cfg.library.empty()) {
+        std::string err;
+        if (library.open(cfg.library, err)) {
+            seed_library = &library;
+            startup.library_patterns = library.count();
+            startup.library_open_ns = library.openNs();
+        } else {
+            std::cerr << "Cannot use pattern library '" << cfg.library << "': " << err << "; seeding soups\n";
+        }
+    }
+
+    std::vector<SDL_Rect> regions, reserve_regions;
+    auto seedAll = [&](int win_w, int win_h) {
+        layoutRegions(regions, universe_count, win_w, win_h, display_regions);
+        layoutRegions(reserve_regions, universe_count, std::max(win_w, virtualBounds.w),
+                      std::max(win_h, virtualBounds.h), display_regions);
+        for (int i = 0; i < universe_count; ++i) {
+            Universe& u = *universes[(size_t)i];
+            u.region = regions[(size_t)i];
+            startup.library_placed += seedUniverse(u, u.region.w, u.region.h, reserve_regions[(size_t)i].w,
+                                                   reserve_regions[(size_t)i].h, seed + (unsigned)i, seed_library);
+        }
+    };
+
+    // Seed the grids on a worker while the window and renderer are created. The window size is known
+    // up front except for the embedded preview (sized by its parent), which seeds after creation.
+    int predict_w = 0, predict_h = 0;
+    if (isFullRun) {
+        predict_w = virtualBounds.w;
+        predict_h = virtualBounds.h;
+    } else if (isWindowedPreview || isHeadless) {
+        predict_w = sargs.window_w;
+        predict_h = sargs.window_h;
+    }
+    // Estimated against the largest regions the universes can get; a replay must keep its cell size.
+    const uint64_t memory_budget = (uint64_t)cfg.memory_budget_mb * 1024 * 1024;
+    if (memory_budget) {
+        layoutRegions(reserve_regions, universe_count, std::max(predict_w, virtualBounds.w),
+                      std::max(predict_h, virtualBounds.h), display_regions);
+        if (!fitMemoryBudget(universes, reserve_regions, !cfg.checkpoint_file.empty(), memory_budget, !isReplay)) {
+            std::cerr << "--memory-budget=" << cfg.memory_budget_mb << " is too small for "
+                      << (isReplay ? "this recording" : "this window") << "\n";
+            SDL_Quit();
+            return 1;
+        }
+    }
+
+    std::thread seeder;
+    if (predict_w > 0 && predict_h > 0) {
+        startup.seeded_on_worker = true;
+        seeder = std::thread([&, predict_w, predict_h] {
+            startup.seed_begin_ns = startup.now();
+            seedAll(predict_w, predict_h);
+            startup.seed_end_ns = startup.now();
+        });
+    }
 
 #ifdef _WIN32
     HWND previewParent = (HWND)sargs.preview_parent_hwnd;
@@ -409,6 +6336,14 @@ int main(int argc, char** argv) {
             sargs.window_w, sargs.window_h,
             SDL_WINDOW_SHOWN | SDL_WINDOW_RESIZABLE
         );
+    } else if (isHeadless) {
+        // Never shown; combine with SDL_VIDEODRIVER=offscreen (or dummy) to run without a display.
+        window = SDL_CreateWindow(
+            isReplay ? "Conway Screen Saver (SDL2) - Replay" : "Conway Screen Saver (SDL2) - Benchmark",
+            SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
+            sargs.window_w, sargs.window_h,
+            SDL_WINDOW_HIDDEN
+        );
     } else {
         // One borderless window that spans the entire virtual desktop (all monitors).
         window = SDL_CreateWindow(
@@ -421,9 +6356,11 @@ int main(int argc, char** argv) {
 
     if (!window) {
         std::cerr << "SDL window creation failed: " << SDL_GetError() << "\n";
+        if (seeder.joinable()) seeder.join();
         SDL_Quit();
         return 1;
     }
+    startup.mark("window");
 
     if (isFullRun) {
         // Make sure it stays above the taskbar / other windows.
@@ -436,62 +6373,417 @@ int main(int argc, char** argv) {
         SDL_RaiseWindow(window);
     }
 
-    SDL_Renderer* ren = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    // Textures are scaled up by whole cells; filtering would blur the cell edges.
+    SDL_SetHint(SDL_HINT_RENDER_SCALE_QUALITY, "nearest");
+    if (!isBenchmark) cfg.render_check = false;
+    SDL_Renderer* ren = cfg.render_check ? nullptr : SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED);
+    if (!ren && isHeadless) ren = SDL_CreateRenderer(window, -1, SDL_RENDERER_SOFTWARE);
     if (!ren) {
         std::cerr << "SDL_CreateRenderer failed: " << SDL_GetError() << "\n";
+        if (seeder.joinable()) seeder.join();
         SDL_DestroyWindow(window);
         SDL_Quit();
         return 1;
     }
+    startup.mark("renderer");
 
-    std::mt19937 rng((unsigned)std::chrono::high_resolution_clock::now().time_since_epoch().count());
+    // Replace whatever the window showed with black right away; the universe follows on the first
+    // loop iteration.
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
+    SDL_RenderClear(ren);
+    SDL_RenderPresent(ren);
+    startup.mark("first_present");
 
-    int grid_w = 0, grid_h = 0;
-    std::vector<uint8_t> cur, nxt;
+    int base_win_w = 0, base_win_h = 0;
+    SDL_GetWindowSize(window, &base_win_w, &base_win_h);
+    startup.join_ns = startup.now();
+    if (seeder.joinable()) seeder.join();
+    if (!startup.seeded_on_worker || base_win_w != predict_w || base_win_h != predict_h) {
+        // Embedded preview, or the window manager gave us another size: seed for the real one.
+        startup.seeded_on_worker = false;
+        startup.seed_begin_ns = startup.now();
+        seedAll(base_win_w, base_win_h);
+        startup.seed_end_ns = startup.now();
+    }
+    for (int i = 0; i < universe_count; ++i) {
+        prepareUniverse(*universes[(size_t)i], reserve_regions[(size_t)i].w, reserve_regions[(size_t)i].h);
+        createUniverseTexture(ren, *universes[(size_t)i], reserve_regions[(size_t)i].w, reserve_regions[(size_t)i].h);
+    }
+    startup.mark("grid_ready");
+
+    // A single universe steps synchronously: every frame waits for the step it started, so replays
+    // stay exact. Several universes step asynchronously: a universe whose step is still running keeps
+    // showing its last generation instead of holding up the frame. Lanes 0..n-1 step the universes,
+    // lanes n..2n-1 rasterise them and lanes 2n..3n-1 count their objects.
+    const bool async_steps = universe_count > 1;
+    WorkerPool pool(std::max(1, (int)std::thread::hardware_concurrency() - 1), 3 * universe_count);
+    const int raster_lane = universe_count;
+    const int census_lane = 2 * universe_count;
+
+    // A soak runs for a duration: generations are unbounded, and the synthetic painting and resizes
+    // keep every code path busy.
+    if (!isBenchmark) cfg.soak_s = 0;
+    const bool isSoak = cfg.soak_s > 0;
+    if (isSoak) {
+        sargs.bench_generations = std::numeric_limits<int>::max();
+        cfg.synthetic_input = true;
+    }
+    if (!isBenchmark) cfg.synthetic_input = cfg.alloc_check = false;
+    if (cfg.alloc_check && !kAllocHook) {
+        std::cerr << "--alloc-check needs a build configured with -DCONWAY_ALLOC_HOOK=ON\n";
+        SDL_DestroyRenderer(ren);
+        SDL_DestroyWindow(window);
+        SDL_Quit();
+        return 1;
+    }
+    SyntheticInput synth;
+    // Warm-up before the allocation check arms: first frames, first resize in each direction.
+    const uint64_t alloc_warmup_gens = std::min<uint64_t>((uint64_t)sargs.bench_generations / 10,
+                                                          2 * SyntheticInput::kResizeEvery + 1);
+    uint64_t allocs_at_arm = 0;
+    bool alloc_armed = false;
+
+    FrameStats stats;
+    stats.engine = engineName(primary.cfg.engine);
+    stats.neighborhood = neighborhoodName(primary.cfg.neighborhood);
+    {
+        int fps = cfg.target_fps;
+        SDL_DisplayMode dm{};
+        if (fps <= 0 && SDL_GetWindowDisplayMode(window, &dm) == 0) fps = dm.refresh_rate;
+        if (fps <= 0) fps = 60;
+        stats.deadline_ns = 1000000000ull / (uint64_t)fps;
+    }
+
+    std::unique_ptr<MetricsExporter> metrics;
+    if (!cfg.metrics_file.empty()) {
+        metrics = std::make_unique<MetricsExporter>(stats, cfg.metrics_file, cfg.metrics_interval_ms);
+    }
+
+    // Only benchmarks and soaks measure energy; opening the counters costs a few syscalls per domain.
+    std::unique_ptr<EnergyMeter> energy;
+    if (isBenchmark) energy = std::make_unique<EnergyMeter>();
+    std::unique_ptr<SoakSampler> soak;
+    std::FILE* soak_csv = nullptr;
+    if (isSoak) {
+        soak_csv = cfg.soak_csv.empty() ? stdout : std::fopen(cfg.soak_csv.c_str(), "w");
+        if (!soak_csv) {
+            std::cerr << "Cannot write soak CSV '" << cfg.soak_csv << "'\n";
+            soak_csv = stdout;
+        }
+        soak = std::make_unique<SoakSampler>(stats, *energy, soak_csv, cfg.soak_interval_s,
+                                             (size_t)(cfg.soak_s / std::max(1, cfg.soak_interval_s)));
+    }
+
+    InputRecorder recorder;
+    if (!cfg.record_file.empty()) {
+        int ww = 0, wh = 0;
+        SDL_GetWindowSize(window, &ww, &wh);
+        if (!recorder.open(cfg.record_file, seed, primary.cfg, ww, wh)) {
+            std::cerr << "Cannot record to '" << cfg.record_file << "'\n";
+        }
+    }
+    size_t replay_next = 0;
+    uint64_t hash_checks = 0;
+    uint64_t hash_diverged_at = UINT64_MAX;
+    uint64_t hash_recorded = 0, hash_replayed = 0;
+
+    std::FILE* hash_log = nullptr;
+    if (!cfg.hash_log_file.empty()) {
+        hash_log = std::fopen(cfg.hash_log_file.c_str(), "w");
+        if (!hash_log) std::cerr << "Cannot write hash log '" << cfg.hash_log_file << "'\n";
+    }
+    stats.grid_hash.set(primary.hash.value());
+    stats.generation.set(primary.generation);
+    stats.memory_budget.set(memory_budget);
+
+    std::unique_ptr<CheckpointWriter> checkpoints;
+    if (!cfg.checkpoint_file.empty()) {
+        checkpoints = std::make_unique<CheckpointWriter>(cfg.checkpoint_file, primary.cur.capacity());
+    }
+    auto last_checkpoint = std::chrono::steady_clock::now();
+    auto last_energy = last_checkpoint;
+    bool over_budget = false;
+
+    std::unique_ptr<DeltaServer> server;
+    if (!cfg.serve.empty()) {
+        std::string host, err;
+        int port = 0;
+        server = std::make_unique<DeltaServer>();
+        if (!parseHostPort(cfg.serve, host, port)) {
+            std::cerr << "--serve needs [HOST:]PORT, got '" << cfg.serve << "'\n";
+            server.reset();
+        } else if (primary.cfg.engine == Engine::Lenia) {
+            std::cerr << "--serve streams cell ages; not available with --engine=lenia\n";
+            server.reset();
+        } else if (!server->start(host, port, primary.cur.capacity(), err)) {
+            std::cerr << "Cannot serve on " << cfg.serve << ": " << err << "\n";
+            server.reset();
+        }
+    }
 
-    resizeGridToWindow(window, cfg, grid_w, grid_h, cur, nxt);
-    randomize(cur, cfg.density, rng);
+    RenderCheck render_check;
+    if (cfg.render_check) {
+        int ow = 0, oh = 0;
+        SDL_GetRendererOutputSize(ren, &ow, &oh);
+        size_t px = (size_t)std::max(ow, virtualBounds.w) * (size_t)std::max(oh, virtualBounds.h);
+        render_check.fast.reserve(px);
+        render_check.reference.reserve(px);
+        render_check.covered.assign(universes.size(), 0);
+    }
 
     bool running = true;
     bool mouse_left = false, mouse_right = false;
+    int mouse_x = 0, mouse_y = 0;
 
-    auto last_step = std::chrono::steady_clock::now();
+    const EnergyTotals energy_start = energy ? energy->sample() : EnergyTotals{};
+    auto run_start = std::chrono::steady_clock::now();
+    auto frame_start = run_start;
+    auto render_begin = run_start, render_end = run_start; // latest raster..present span
+    bool first_frame = true;
+    bool universe_shown = false;
+    for (auto& u : universes) {
+        u->last_step = run_start;
+        u->profile = cfg.cost_map;
+    }
 
-    while (running) {
-        SDL_Event e;
-        while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_QUIT) running = false;
+    auto sinceStartUs = [&] {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - run_start).count();
+    };
 
-            if (e.type == SDL_WINDOWEVENT) {
-                if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED ||
-                    e.window.event == SDL_WINDOWEVENT_RESIZED) {
-                    resizeGridToWindow(window, cfg, grid_w, grid_h, cur, nxt);
+    // Make a finished step current and update the stats (the primary universe drives the
+    // generation, checksum, hash log and recording).
+    auto publish = [&](size_t i) {
+        Universe& u = *universes[i];
+        bool painted = !u.pending.empty(); // applied after the step, so not covered by its checksum
+        publishStep(u);
+        u.run_ns = elapsedNs(run_start, std::chrono::steady_clock::now());
+        stats.recordStep(u.step_ns);
+        stats.tally.record(u.tally_ns);
+        auto step_end = u.submitted + std::chrono::nanoseconds(u.step_ns);
+        auto overlap_begin = std::max(u.submitted, render_begin), overlap_end = std::min(step_end, render_end);
+        stats.step_busy_ns.add(u.step_ns);
+        if (overlap_end > overlap_begin) stats.step_overlap_ns.add(elapsedNs(overlap_begin, overlap_end));
+        uint64_t population = 0;
+        for (const auto& v : universes) population += v->published_population;
+        stats.population.set(population);
+        if (i != 0) return;
+
+        uint64_t hv = u.hash.value();
+        if (recorder.isOpen() || hash_log) {
+            auto t0 = std::chrono::steady_clock::now();
+            if (recorder.isOpen()) recorder.recordHash(hv, sinceStartUs(), u.generation);
+            if (hash_log) std::fprintf(hash_log, "%llu %016llx\n", (unsigned long long)u.generation, (unsigned long long)hv);
+            stats.record.record(elapsedNs(t0, std::chrono::steady_clock::now()));
+        }
+        if (server) {
+            server->offer(u.cur, u.grid_w, u.grid_h, u.generation, u.cfg.neighborhood, u.cfg.max_age, hv,
+                          !u.cfg.hash_ages && !painted);
+        }
+        stats.generation.set(u.generation);
+        stats.grid_hash.set(hv);
+        stats.grid_w.set((uint64_t)u.grid_w);
+        stats.grid_h.set((uint64_t)u.grid_h);
+    };
+    // Generations the next step advances: a replay reproduces the recording one generation at a time,
+    // a benchmark stops exactly at N.
+    auto gensDue = [&](const Universe& u) {
+        uint64_t k = isReplay ? 1 : (uint64_t)u.cfg.gens_per_step;
+        if (isBenchmark) k = std::min(k, (uint64_t)sargs.bench_generations - std::min(u.generation, (uint64_t)sargs.bench_generations));
+        return (int)std::max<uint64_t>(1, k);
+    };
+    // Wait for a universe's step in flight, if any, and publish it.
+    auto settle = [&](size_t i) {
+        if (!universes[i]->in_flight) return;
+        pool.wait((int)i);
+        publish(i);
+    };
+    auto universeAt = [&](int px, int py) -> size_t {
+        for (size_t i = 0; i < universes.size(); ++i) {
+            const SDL_Rect& r = universes[i]->region;
+            if (px >= r.x && px < r.x + r.w && py >= r.y && py < r.y + r.h) return i;
+        }
+        return 0;
+    };
+
+    auto handleEvent = [&](const SDL_Event& e) {
+        if (recorder.isOpen()) recorder.record(e, sinceStartUs(), primary.generation);
+
+        if (e.type == SDL_QUIT) running = false;
+        // Some renderers lose texture contents along with their render targets.
+        if (e.type == SDL_RENDER_TARGETS_RESET) {
+            for (auto& u : universes) u->raster_dirty = true;
+        }
+
+        if (e.type == SDL_WINDOWEVENT) {
+            if (e.window.event == SDL_WINDOWEVENT_SIZE_CHANGED ||
+                e.window.event == SDL_WINDOWEVENT_RESIZED) {
+                layoutRegions(regions, universe_count, e.window.data1, e.window.data2, display_regions);
+                for (size_t i = 0; i < universes.size(); ++i) {
+                    settle(i);
+                    resizeUniverse(*universes[i], regions[i]);
                 }
             }
+        }
 
-            if (e.type == SDL_KEYDOWN) {
-                if (e.key.keysym.sym == SDLK_ESCAPE) running = false;
+        if (e.type == SDL_KEYDOWN) {
+            if (e.key.keysym.sym == SDLK_ESCAPE) running = false;
+            if (e.key.keysym.sym == SDLK_h) {
+                printLatencyReport(std::cout, stats);
+                printMemoryReport(std::cout, stats);
+                printUniverseReport(std::cout, universes);
+                printCostMapReport(std::cout, universes);
+                printCensusReport(std::cout, universes);
             }
-
-            if (e.type == SDL_MOUSEBUTTONDOWN) {
-                if (e.button.button == SDL_BUTTON_LEFT)  mouse_left = true;
-                if (e.button.button == SDL_BUTTON_RIGHT) mouse_right = true;
+            if (e.key.keysym.sym == SDLK_a) {
+                // Starts the activity map of the universe under the mouse, or exports it.
+                size_t i = universeAt(mouse_x, mouse_y);
+                settle(i);
+                Universe& u = *universes[i];
+                if (!u.track_activity) {
+                    u.activity.assign(u.cur.size(), 0);
+                    u.activity_since = u.generation;
+                    u.track_activity = true;
+                    std::cout << "activity map started at generation " << u.generation << "\n";
+                } else {
+                    bool raw = (e.key.keysym.mod & KMOD_SHIFT) != 0;
+                    std::string path = cfg.export_dir.empty() ? std::string() : cfg.export_dir + "/";
+                    path += "conway-activity-" + (universes.size() > 1 ? "u" + std::to_string(i) + "-" : std::string()) +
+                            "gen" + std::to_string(u.generation) + "-" + std::to_string(u.grid_w) + "x" +
+                            std::to_string(u.grid_h) + (raw ? ".raw" : ".pgm");
+                    bool ok = exportActivity(u.activity, u.grid_w, u.grid_h, u.activity_since, u.generation, path, raw);
+                    (ok ? std::cout : std::cerr) << (ok ? "exported " : "export failed: ") << path << "\n";
+                }
             }
-            if (e.type == SDL_MOUSEBUTTONUP) {
-                if (e.button.button == SDL_BUTTON_LEFT)  mouse_left = false;
-                if (e.button.button == SDL_BUTTON_RIGHT) mouse_right = false;
+            if (e.key.keysym.sym == SDLK_o) {
+                // Toggles the object census of the universe under the mouse. The pool notes the tiles
+                // a step changes for it, so flip it between steps.
+                size_t i = universeAt(mouse_x, mouse_y);
+                settle(i);
+                Universe& u = *universes[i];
+                if (u.cfg.engine == Engine::Lenia) {
+                    if (!isReplay) std::cout << "object census: not for lenia\n";
+                } else if (u.track_census) {
+                    u.track_census = false;
+                } else {
+                    int cell = std::max(1, u.cfg.cell_px);
+                    startCensus(u, std::max(reserve_regions[i].w / cell, u.grid_w), std::max(reserve_regions[i].h / cell, u.grid_h));
+                }
+            }
+            if (e.key.keysym.sym == SDLK_p) {
+                // The pool reads `profile` during a step, so flip it between steps.
+                for (size_t i = 0; i < universes.size(); ++i) {
+                    settle(i);
+                    Universe& u = *universes[i];
+                    u.profile = !u.profile;
+                    std::fill(u.cost_map.begin(), u.cost_map.end(), 0.0f);
+                }
+            }
+            if (e.key.keysym.sym == SDLK_f) {
+                // Fast-forward the universe under the mouse: 1, 4, 16, 64 generations per step. Takes
+                // effect with the next step.
+                Universe& u = *universes[universeAt(mouse_x, mouse_y)];
+                u.cfg.gens_per_step = u.cfg.gens_per_step >= 64 ? 1 : u.cfg.gens_per_step * 4;
+                if (u.cfg.engine == Engine::Dense && u.cfg.gens_per_step > 1) u.spare.reserve(u.cur.capacity());
+                if (!isReplay) std::cout << "fast-forward: " << u.cfg.gens_per_step << " generations per step\n";
+            }
+            if (e.key.keysym.sym == SDLK_c) {
+                // Colour cycling of the universe under the mouse; off keeps the current colours.
+                Universe& u = *universes[universeAt(mouse_x, mouse_y)];
+                u.cfg.color_cycle_s = u.cfg.color_cycle_s ? 0 : (cfg.color_cycle_s ? cfg.color_cycle_s : 60);
+                if (!isReplay) {
+                    std::cout << "colour cycling: "
+                              << (u.cfg.color_cycle_s ? std::to_string(u.cfg.color_cycle_s) + " s per turn" : "off") << "\n";
+                }
+            }
+            if (e.key.keysym.sym == SDLK_e) {
+                // Exports the universe under the mouse.
+                size_t i = universeAt(mouse_x, mouse_y);
+                settle(i);
+                const Universe& u = *universes[i];
+                bool plain = (e.key.keysym.mod & KMOD_SHIFT) != 0;
+                std::string path = cfg.export_dir.empty() ? std::string() : cfg.export_dir + "/";
+                path += "conway-" + (universes.size() > 1 ? "u" + std::to_string(i) + "-" : std::string()) +
+                        "gen" + std::to_string(u.generation) + (plain ? ".cells" : ".rle");
+                bool ok = plain ? exportPlaintext(u.cur, u.grid_w, u.grid_h, u.generation, path)
+                                : exportRle(u.cur, u.grid_w, u.grid_h, u.cfg.wrap, u.cfg.neighborhood, u.cfg.rule,
+                                            u.generation, path);
+                (ok ? std::cout : std::cerr) << (ok ? "exported " : "export failed: ") << path << "\n";
+            }
+        }
+
+        if (e.type == SDL_MOUSEBUTTONDOWN) {
+            if (e.button.button == SDL_BUTTON_LEFT)  mouse_left = true;
+            if (e.button.button == SDL_BUTTON_RIGHT) mouse_right = true;
+        }
+        if (e.type == SDL_MOUSEBUTTONUP) {
+            if (e.button.button == SDL_BUTTON_LEFT)  mouse_left = false;
+            if (e.button.button == SDL_BUTTON_RIGHT) mouse_right = false;
+        }
+
+        if (e.type == SDL_MOUSEMOTION || e.type == SDL_MOUSEBUTTONDOWN) {
+            // Use the event's own coordinates (not SDL_GetMouseState) so injected events paint too.
+            mouse_x = (e.type == SDL_MOUSEMOTION) ? e.motion.x : e.button.x;
+            mouse_y = (e.type == SDL_MOUSEMOTION) ? e.motion.y : e.button.y;
+            if (mouse_left || mouse_right) {
+                paintUniverse(*universes[universeAt(mouse_x, mouse_y)], mouse_x, mouse_y, mouse_left);
             }
+        }
+    };
+
+    while (running) {
+        auto frame_now = std::chrono::steady_clock::now();
+        if (!first_frame) stats.recordFrame(elapsedNs(frame_start, frame_now));
+        frame_start = frame_now;
+        first_frame = false;
+
+        if (cfg.alloc_check && !alloc_armed && primary.generation >= alloc_warmup_gens) {
+            allocs_at_arm = allocCount();
+            armAllocCounter(true);
+            alloc_armed = true;
+        }
+        // Frame graph: input -> { step g -> g+1 on the pool || raster g -> upload -> present } ->
+        // publish g+1 (stats, recording). Input and publishing run while no step is in flight (a single
+        // universe) or on a universe whose step finished, so only the step overlaps the drawing.
+        auto input_begin = std::chrono::steady_clock::now();
+        if (cfg.synthetic_input) synth.pump(window, base_win_w, base_win_h);
+
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) {
+            // During replay only the way out is live; the log supplies all other input.
+            if (isReplay && !(e.type == SDL_QUIT ||
+                              (e.type == SDL_KEYDOWN && e.key.keysym.sym == SDLK_ESCAPE))) continue;
+            handleEvent(e);
+        }
 
-            if (e.type == SDL_MOUSEMOTION || e.type == SDL_MOUSEBUTTONDOWN) {
-                int mx = 0, my = 0;
-                SDL_GetMouseState(&mx, &my);
-                int cell = std::max(1, cfg.cell_px);
-                int gx = mx / cell;
-                int gy = my / cell;
-                if (mouse_left)  setCell(cur, grid_w, grid_h, gx, gy, true);
-                if (mouse_right) setCell(cur, grid_w, grid_h, gx, gy, false);
+        if (isReplay) {
+            // max: events are keyed to the generation they preceded, so the run is deterministic.
+            // realtime: events fire at their recorded time and steps follow the recorded ms_per_step.
+            uint64_t t_us = sinceStartUs();
+            while (replay_next < replay.events.size()) {
+                const LoggedEvent& le = replay.events[replay_next];
+                bool due = cfg.replay_max_speed ? (le.gen <= primary.generation) : (le.t_us <= t_us);
+                if (!due) break;
+                ++replay_next;
+                if (le.end) { running = false; break; }
+                if (le.has_hash) {
+                    // Only a max-speed replay reproduces the recorded generations exactly.
+                    if (cfg.replay_max_speed && le.gen == primary.generation) {
+                        ++hash_checks;
+                        if (hash_diverged_at == UINT64_MAX && le.hash != stats.grid_hash.get()) {
+                            hash_diverged_at = primary.generation;
+                            hash_recorded = le.hash;
+                            hash_replayed = stats.grid_hash.get();
+                        }
+                    }
+                    continue;
+                }
+                if (le.e.type == SDL_WINDOWEVENT) SDL_SetWindowSize(window, le.e.window.data1, le.e.window.data2);
+                handleEvent(le.e);
             }
+            if (!running) continue;
         }
+        stats.input.record(elapsedNs(input_begin, std::chrono::steady_clock::now()));
 
 #ifdef _WIN32
         if (isEmbeddedPreview) {
@@ -507,41 +6799,244 @@ int main(int argc, char** argv) {
         }
 #endif
 
+        // Publish finished steps, then start the next step of every universe that is due. Lanes are
+        // served round-robin, so each universe gets its share of the pool whatever the others cost.
+        // The runs engine updates `cur` in place, so its step waits until `cur` has been drawn.
         auto now = std::chrono::steady_clock::now();
-        bool time_to_step = (cfg.ms_per_step == 0)
-            ? true
-            : (std::chrono::duration_cast<std::chrono::milliseconds>(now - last_step).count() >= cfg.ms_per_step);
+        bool all_done = isBenchmark;
+        for (size_t i = 0; i < universes.size(); ++i) {
+            Universe& u = *universes[i];
+            if (u.in_flight && !pool.busy((int)i)) publish(i);
+            bool finished = isBenchmark && u.generation >= (uint64_t)sargs.bench_generations;
+            all_done = all_done && finished && !u.in_flight;
+            bool time_to_step = (u.cfg.ms_per_step == 0)
+                ? true
+                : (std::chrono::duration_cast<std::chrono::milliseconds>(now - u.last_step).count() >= u.cfg.ms_per_step);
+            u.step_due = !u.in_flight && time_to_step && !finished;
+            if (u.step_due) u.last_step = now;
+            if (u.step_due && u.cfg.engine != Engine::Runs) submitStep(pool, (int)i, u, gensDue(u));
+        }
 
-        if (time_to_step) {
-            stepLife(cur, nxt, grid_w, grid_h, cfg.wrap, cfg.max_age);
-            cur.swap(nxt);
-            last_step = now;
+        render_begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < universes.size(); ++i) {
+            Universe& u = *universes[i];
+            if (u.cfg.engine == Engine::Runs && !u.step_due) settle(i);
+            advancePalette(u, render_begin);
+            u.rastering = u.texture && u.raster_dirty;
+            if (u.rastering) submitRaster(pool, raster_lane + (int)i, u);
+            u.censusing = u.track_census && u.census.due();
+            if (u.censusing) submitCensus(pool, census_lane + (int)i, u);
+        }
+        for (size_t i = 0; i < universes.size(); ++i) {
+            Universe& u = *universes[i];
+            if (u.rastering) {
+                pool.wait(raster_lane + (int)i);
+                stats.raster.record(u.raster_ns);
+            }
+            if (u.censusing) {
+                pool.wait(census_lane + (int)i);
+                stats.census.record(u.census_ns);
+            }
+            if (u.step_due && u.cfg.engine == Engine::Runs && u.texture) submitStep(pool, (int)i, u, gensDue(u));
         }
 
+        auto upload_begin = std::chrono::steady_clock::now();
+        for (auto& u : universes) {
+            if (u->rastering) uploadUniverse(*u);
+        }
+        auto present_begin = std::chrono::steady_clock::now();
+        stats.upload.record(elapsedNs(upload_begin, present_begin));
         SDL_SetRenderDrawColor(ren, 0, 0, 0, 255);
         SDL_RenderClear(ren);
+        for (auto& u : universes) {
+            renderUniverse(ren, *u);
+            if (u->profile) renderCostMap(ren, *u);
+            if (u->track_census) renderCensus(ren, *u);
+        }
+        SDL_RenderPresent(ren);
+        render_end = std::chrono::steady_clock::now();
+        stats.present.record(elapsedNs(present_begin, render_end));
+        for (size_t i = 0; i < universes.size(); ++i) {
+            Universe& u = *universes[i];
+            if (u.step_due && u.cfg.engine == Engine::Runs && !u.texture) submitStep(pool, (int)i, u, gensDue(u));
+        }
 
-        SDL_Rect r{0, 0, cfg.cell_px, cfg.cell_px};
-        for (int y = 0; y < grid_h; ++y) {
-            for (int x = 0; x < grid_w; ++x) {
-                uint8_t age = cur[idx(x, y, grid_w)];
-                if (!age) continue;
+        if (!async_steps) {
+            settle(0);
+            if (isBenchmark && primary.generation >= (uint64_t)sargs.bench_generations) all_done = true;
+        }
+        if (cfg.render_check) {
+            for (size_t i = 0; i < universes.size(); ++i) settle(i);
+            checkRender(ren, pool, raster_lane, universes, primary.generation, render_check);
+        }
+        if (all_done) running = false;
+        if (isSoak && now - run_start >= std::chrono::seconds(cfg.soak_s)) running = false;
 
-                SDL_Color c = colorForAge(age, cfg.max_age);
-                SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, 255);
+        if (energy && energy->available() && now - last_energy >= std::chrono::seconds(1)) {
+            energy->sample(); // keeps up with counter wraps; the report takes the difference at the end
+            last_energy = now;
+        }
+        if (checkpoints && now - last_checkpoint >= std::chrono::seconds(cfg.checkpoint_interval_s)) {
+            auto t0 = std::chrono::steady_clock::now();
+            if (checkpoints->trySnapshot(primary.cur, primary.grid_w, primary.grid_h, primary.generation)) {
+                stats.snapshot.record(elapsedNs(t0, std::chrono::steady_clock::now()));
+                last_checkpoint = now;
+            }
+        }
 
-                r.x = x * cfg.cell_px;
-                r.y = y * cfg.cell_px;
-                SDL_RenderFillRect(ren, &r);
+        MemoryLedger mem;
+        for (const auto& u : universes) measureUniverse(*u, mem);
+        if (checkpoints) mem[MemoryKind::Checkpoint] = checkpoints->bytes();
+        if (server) mem[MemoryKind::Stream] = server->bytes();
+        for (int k = 0; k < kMemoryKinds; ++k) stats.memory[(size_t)k].set(mem.bytes[(size_t)k]);
+        if (memory_budget && mem.total() > memory_budget) {
+            if (shedMemory(universes)) {
+                std::cerr << "memory budget exceeded (" << std::fixed << std::setprecision(1) << mib(mem.total())
+                          << " MiB): textures released, drawing cells as rectangles\n";
+            } else if (!over_budget) {
+                std::cerr << "memory budget exceeded (" << std::fixed << std::setprecision(1) << mib(mem.total())
+                          << " MiB) with nothing left to release\n";
             }
+            over_budget = true;
         }
 
-        SDL_RenderPresent(ren);
-        SDL_Delay(1);
+        if (!universe_shown) {
+            startup.mark("first_frame");
+            universe_shown = true;
+        }
+        if (!isHeadless || (isReplay && !cfg.replay_max_speed)) SDL_Delay(1);
+    }
+    for (size_t i = 0; i < universes.size(); ++i) settle(i);
+    for (size_t i = 0; i < universes.size(); ++i) {
+        // The census report counts the final generation.
+        Universe& u = *universes[i];
+        if (!u.track_census || !u.census.due()) continue;
+        submitCensus(pool, census_lane + (int)i, u);
+        pool.wait(census_lane + (int)i);
+    }
+
+    armAllocCounter(false);
+    int exit_code = 0;
+    if (soak) soak->stop();
+    if (server) {
+        server->stop();
+        server->report(std::cout);
+    }
+
+    if (recorder.isOpen()) {
+        uint64_t recorded = recorder.events();
+        recorder.finish(sinceStartUs(), primary.generation);
+        std::cout << "recorded " << recorded << " events, " << primary.generation << " generations to "
+                  << cfg.record_file << "\n";
+    }
+
+    if (isBenchmark && !cfg.bench_export.empty()) {
+        auto t0 = std::chrono::steady_clock::now();
+        const Universe& u = primary;
+        bool ok = endsWith(lower(cfg.bench_export), ".cells")
+            ? exportPlaintext(u.cur, u.grid_w, u.grid_h, u.generation, cfg.bench_export)
+            : exportRle(u.cur, u.grid_w, u.grid_h, u.cfg.wrap, u.cfg.neighborhood, u.cfg.rule, u.generation,
+                        cfg.bench_export);
+        std::cout << "export: " << (ok ? "" : "FAILED ") << cfg.bench_export << " in " << std::fixed
+                  << std::setprecision(3) << (double)elapsedNs(t0, std::chrono::steady_clock::now()) / 1e6 << " ms\n";
+        if (!ok) exit_code = 1;
+    }
+
+    if (isBenchmark && !cfg.activity_export.empty()) {
+        const Universe& u = primary;
+        bool ok = exportActivity(u.activity, u.grid_w, u.grid_h, u.activity_since, u.generation, cfg.activity_export,
+                                 endsWith(lower(cfg.activity_export), ".raw"));
+        std::cout << "activity export: " << (ok ? "" : "FAILED ") << cfg.activity_export << "\n";
+        if (!ok) exit_code = 1;
     }
 
+    if (isHeadless) {
+        double secs = (double)elapsedNs(run_start, std::chrono::steady_clock::now()) / 1e9;
+        std::cout << (isReplay ? "replay: " : "benchmark: ") << primary.grid_w << "x" << primary.grid_h << " cells ("
+                  << engineName(primary.cfg.engine) << ", " << ruleLabel(primary.cfg)
+                  << "), " << primary.generation << " generations in " << std::fixed << std::setprecision(3) << secs
+                  << " s (" << std::setprecision(1) << (secs > 0 ? (double)primary.generation / secs : 0.0) << " gen/s, "
+                  << (secs > 0 ? (double)(stats.frame.count() + 1) / secs : 0.0) << " fps)\n";
+        if (energy) {
+            EnergyTotals end = energy->sample();
+            EnergyTotals used{end.package_j - energy_start.package_j, end.dram_j - energy_start.dram_j};
+            SDL_RendererInfo info{};
+            const char* renderer = SDL_GetRendererInfo(ren, &info) == 0 && info.name ? info.name : "unknown";
+            printEnergyReport(std::cout, *energy, used, secs, primary.generation, stats.frame.count() + 1, renderer);
+        }
+    }
+    printStartupReport(std::cout, startup);
+    printLatencyReport(std::cout, stats);
+    printMemoryReport(std::cout, stats);
+    printUniverseReport(std::cout, universes);
+    printCostMapReport(std::cout, universes);
+    printCensusReport(std::cout, universes);
+    if (isReplay && cfg.replay_max_speed) {
+        if (hash_diverged_at == UINT64_MAX) {
+            std::cout << "hash check: " << hash_checks << " generations match the recording\n";
+        } else {
+            std::cout << "hash check: DIVERGED at generation " << hash_diverged_at << std::hex
+                      << " (recorded " << hash_recorded << ", replayed " << hash_replayed << ")" << std::dec << "\n";
+            exit_code = 1;
+        }
+    }
+    if (hash_log) std::fclose(hash_log);
+    if (cfg.render_check && !printRenderCheckReport(std::cout, render_check)) exit_code = 1;
+    for (size_t i = 0; i < universes.size(); ++i) {
+        const Universe& u = *universes[i];
+        if (!u.cfg.verify) continue;
+        std::string who = universes.size() > 1 ? "universe " + std::to_string(i) + " " : std::string();
+        if (u.verify_failed_at == UINT64_MAX) {
+            if (u.cfg.engine == Engine::Lenia) {
+                std::cout << "verify: " << who << u.verify_steps << " lenia steps match a direct convolution (max error "
+                          << std::scientific << std::setprecision(2) << u.lenia_error << std::defaultfloat << ")\n";
+            } else {
+                std::cout << "verify: " << who << u.verify_steps << " " << engineName(u.cfg.engine) << " "
+                          << neighborhoodName(u.cfg.neighborhood) << " steps match the reference kernel\n";
+            }
+        } else {
+            std::cout << "verify: " << who << engineName(u.cfg.engine) << " " << neighborhoodName(u.cfg.neighborhood)
+                      << " engine DIVERGED from the reference kernel at generation "
+                      << u.verify_failed_at << "\n";
+            exit_code = 1;
+        }
+    }
+    if (checkpoints) {
+        // Final checkpoint so the next start resumes exactly here.
+        checkpoints->waitIdle();
+        auto t0 = std::chrono::steady_clock::now();
+        checkpoints->trySnapshot(primary.cur, primary.grid_w, primary.grid_h, primary.generation);
+        stats.snapshot.record(elapsedNs(t0, std::chrono::steady_clock::now()));
+        checkpoints->waitIdle();
+        std::cout << "checkpoint: " << checkpoints->written() << " written (" << checkpoints->failed()
+                  << " failed), last " << checkpoints->lastBytes() << " bytes in " << std::fixed << std::setprecision(3)
+                  << (double)checkpoints->lastWriteNs() / 1e6 << " ms on the I/O thread; snapshot p99 "
+                  << (double)stats.snapshot.percentile(99.0) / 1e6 << " ms on the main thread\n";
+        checkpoints.reset();
+    }
+    if (soak) {
+        if (!reportSoak(std::cout, soak->samples(), (double)elapsedNs(run_start, std::chrono::steady_clock::now()) / 1e9)) {
+            exit_code = 1;
+        }
+        soak.reset();
+        if (soak_csv != stdout) std::fclose(soak_csv);
+    }
+    if (cfg.synthetic_input) {
+        std::cout << "synthetic input: " << synth.paints << " paint events, " << synth.resizes << " resizes\n";
+    }
+    if (cfg.alloc_check) {
+        uint64_t allocs = alloc_armed ? allocCount() - allocs_at_arm : 0;
+        std::cout << "alloc check: " << allocs << " allocations after " << alloc_warmup_gens
+                  << " warm-up generations" << (alloc_armed ? "" : " (never armed: run more generations)") << "\n";
+        if (allocs != 0 || !alloc_armed) exit_code = 1;
+    }
+    metrics.reset();
+
+    for (auto& u : universes) {
+        if (u->texture) SDL_DestroyTexture(u->texture);
+    }
     SDL_DestroyRenderer(ren);
     SDL_DestroyWindow(window);
     SDL_Quit();
-    return 0;
+    return exit_code;
 }